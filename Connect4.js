@@ -6,28 +6,79 @@
  
 /**
  * @fileOverview The actual public API for the Connect 4 game. It uses Web Workers to offload the heavy computations.
- * This is the only JS file that needs to be included but make sure that Connect4Worker.js and Connect4Game.js are
- * in the same directory.
+ * This is the only JS file that needs to be included but make sure that Connect4Worker.js, Connect4Game.js,
+ * Connect4Table.js and Connect4Tablebase.js are in the same directory.
  */
 
 /**
  * Creates a new Connect 4 game asynchronously using Web Workers. A simple pubsub system is used to manage
- * the asynchronous behavior. The valid events are: gamestart, movestart, moveend, gameend, and debug. Each
- * event receives different arguments. The gamestart event receives only the instance of the Connect 4 game.
- * The movestart event receives the player (0 for player 1, 1 for player 2) that is moving and the instance 
- * of the Connect 4 game. The moveend event receives the player (0 for player 1, 1 for player 2), the column, the row,
- * and the instance of the Connect 4 game. The gameend event receives only the instance of the Connect 4 game.
- * The debug event receives a debug object.
+ * the asynchronous behavior. The valid events are: gamestart, movestart, moveend, gameend, solveprogress,
+ * checkpoint, trace, flag, error, and debug. Each event receives different arguments. The gamestart event receives only the
+ * instance of the Connect 4 game. The movestart event receives the player (0 for player 1, 1 for player 2) that is
+ * moving and the instance of the Connect 4 game. The moveend event receives the player (0 for player 1, 1 for
+ * player 2), the column, the row, and the instance of the Connect 4 game. The gameend event receives only the
+ * instance of the Connect 4 game. The solveprogress event receives a progress object (see solve) and the
+ * checkpoint event receives a checkpoint object to pass to resumeSolve. The trace event receives the searched
+ * tree of an autoMove when the trace setting is on (see Connect4Game#autoMove and Connect4.summarizeTrace). The
+ * flag event receives the player whose clock ran out and the instance of the Connect 4 game. The error event
+ * receives an object with the action that failed in a worker as action and the error as message, and the
+ * instance of the Connect 4 game; whatever the action was part of is given up, so a failed move or solve is no
+ * longer in progress and the callback of a failed perft or indexGames is not called. The debug event receives a
+ * debug object.
  *
  * @param {object} [settings] The settings for the game.
  * @param {number} [settings.cols = 7] The number of columns.
  * @param {number} [settings.rows = 6] The number of rows.
  * @param {number} [settings.connect = 4] The number of pieces to connect to win.
- * @param {number} [settings.ai = 4] The default level to walk the tree of possible moves.
+ * @param {number|string|object} [settings.ai = 4] The default level to walk the tree of possible moves, or a
+ *                                                difficulty: the name of a preset budget or a budget of its own
+ *                                                (see Connect4Game.difficulties).
+ * @param {boolean} [settings.autoConfigure = true] Whether to pick the settings that are not given based on the
+ *                                           hardware, see Connect4.configure.
+ * @param {number} [settings.workers = 2] How many workers of the shared pool a solve may use at once.
+ * @param {number} [settings.splitDepth = 2] How many moves deep a solve is split into jobs for the pool.
+ * @param {number} [settings.checkpointInterval = 60000] How often, in milliseconds, a solve publishes a checkpoint.
+ * @param {number} [settings.moveDeadline = 2000] How many milliseconds autoMove has to find a move before it
+ *                                                counts as a missed deadline.
+ * @param {number} [settings.deepLevel = 8] The level above which an autoMove that no budget, quota or clock
+ *                                          bounds runs in the background, see autoMove.
+ * @param {boolean} [settings.degrade = true] Whether autoMove searches fewer levels while the page is overloaded,
+ *                                            see Connect4.overload.
+ * @param {number} [settings.idleTimeout = 300000] How many milliseconds a game may sit idle, without a move or a
+ *                                               solve, before it is compacted, 0 to never compact it. A compacted
+ *                                               game keeps only its moves: its worker is stopped and the shared
+ *                                               pool drops its replicas, and both are brought back in the position
+ *                                               of the game on its next move. The properties below are kept up to
+ *                                               date throughout.
+ * @param {object} [settings.clock] A Fischer clock for both players: base, the milliseconds each starts with,
+ *                                  and increment, the milliseconds added after each of their moves. autoMove then
+ *                                  manages the time of the player it moves for (see Connect4Game.clock).
+ * @param {boolean} [settings.trace = false] Whether autoMove records the tree it searched for the trace event.
+ * @param {object} [settings.book] An opening book mapping position keys (see positionKey) to the column to play.
+ *                                 Only one of a position and its mirror image needs to be listed.
+ * @param {object} [settings.tablebase] A table of win/draw/loss values, see Connect4Tablebase.
+ * @param {number} [settings.tablebaseCache = 64] The number of decoded tablebase blocks to keep.
+ * @param {number} [settings.sliceNodes = 2000] How many positions a pool worker solves or searches before
+ *                                           checking its messages.
+ * @param {number} [settings.tableSize = 262144] The number of slots in the main transposition table, 0 for none.
+ * @param {number} [settings.shallowTableSize = 4096] The number of slots in the small transposition table for
+ *                                                    nodes close to the leaves, 0 to use the main one for all.
+ * @param {number} [settings.shallowDepth = 2] How close to the leaves a node is to use the small table.
+ * @param {boolean} [settings.shareTables = true] Whether the game shares its transposition tables with the other
+ *                                               games of the same board and table sizes whose searches run in
+ *                                               the same pool worker. Games with a tablebase never do.
+ * @param {number} [settings.seed] Makes autoMove deterministic: the move then only depends on the position, the
+ *                                 level and the seed, which makes a reported move reproducible.
+ * @param {object} [settings.quota] Hard caps on what the game may use: nodes and time, the most positions and
+ *                                  milliseconds a single autoMove or solve may take, tableSize, the most slots of
+ *                                  transposition table, and workers, the most workers of the shared pool a solve
+ *                                  may use at once. A search that reaches a cap is cut short inside the workers
+ *                                  and returns the best it found so far marked as truncated.
  * @param {function} [callback] The callback to be called once the game is ready.
  * @param {object} [context = Connect4 instance] The context for the callback.
  *
  * @property {boolean} moveInProgress True if a move is in progress, false otherwise.
+ * @property {boolean} solveInProgress True if a solve is in progress, false otherwise.
  * @property {boolean} gameOver True if the game is over, false otherwise.
  * @property {number} winner The winner of the game, -1 if no winner. Player 1 is 0 and Player 2 is 1.
  * @property {boolean} tie True if the game is over and resulted in a tie, false otherwise.
@@ -51,6 +102,13 @@
  * @property {number} connect The number of pieces to connect to win.
  * @property {number} numberOfPieces The total number of pieces currently played.
  * @property {array} winningCoords The winning coordinates.
+ * @property {string} positionKey The canonical key of the current position, as used by the opening book.
+ * @property {boolean} truncated True if the quota setting cut the search of the last move made by autoMove short.
+ * @property {array} clock The milliseconds left on the clock of each player with the clock setting, or null. A
+ *                         player's clock runs from the end of the move before theirs to the end of theirs.
+ * @property {boolean} compacted True if the game is compacted, see the idleTimeout setting.
+ * @property {object} configuration The hardware that was detected and the settings picked for it, see
+ *                                  Connect4.configure, or null if autoConfigure is off.
  */
 function Connect4(settings, callback, context) {
     if (typeof settings === 'function') {
@@ -59,8 +117,52 @@ function Connect4(settings, callback, context) {
         settings = {};
     }
 
+    settings = settings || {};
+
+    this._settings = {};
+    for (var key in Connect4.settings.defaults) {
+        if (!Connect4.settings.defaults.hasOwnProperty(key)) { continue; }
+        var setting = settings[key];
+        this._settings[key] = setting !== undefined ? setting : Connect4.settings.defaults[key];
+    }
+
+    // settings picked for the hardware fill in whatever was not given, for this API and for the worker alike
+    this._gameSettings = {};
+    for (var key in settings) {
+        if (settings.hasOwnProperty(key)) {
+            this._gameSettings[key] = settings[key];
+        }
+    }
+
+    this.configuration = this._settings.autoConfigure ? Connect4.configure(settings) : null;
+    for (var key in (this.configuration && this.configuration.settings)) {
+        if (this.configuration.settings.hasOwnProperty(key)) {
+            var target = Connect4.settings.defaults.hasOwnProperty(key) ? this._settings : this._gameSettings;
+            target[key] = this.configuration.settings[key].value;
+        }
+    }
+
+    // games whose engines have the same settings find the same moves, which lets their searches be shared (see
+    // autoMove), whatever the settings of this API
+    var engineSettings = {};
+    for (var key in this._gameSettings) {
+        if (this._gameSettings.hasOwnProperty(key) && !Connect4.settings.defaults.hasOwnProperty(key)) {
+            engineSettings[key] = this._gameSettings[key];
+        }
+    }
+    this._settingsKey = Connect4._hash(JSON.stringify(engineSettings));
+
     this._subscribers = {};
+    this._pending = 0;
+    // the tasks of the game queued or running in the pool, which need its replicas there
+    this._poolTasks = 0;
+    this._closed = false;
+    this._engineMetrics = null;
+    this._moves = [];
+    this._searched = null;
+    this._solveJob = null;
     this.moveInProgress = false;
+    this.solveInProgress = false;
     this.gameOver = false;
     this.winner = -1;
     this.tie = false;
@@ -73,181 +175,2639 @@ function Connect4(settings, callback, context) {
     this.connect = 0;
     this.numberOfPieces = 0;
     this.winningCoords = [];
+    this.positionKey = '';
+    this.clock = this._settings.clock ? [this._settings.clock.base, this._settings.clock.base] : null;
+    this._clockStarted = null;
+    this._quota = this._gameSettings.quota || null;
+    this.truncated = false;
+    this.compacted = false;
+    this._idleTimer = null;
+    this._rehydrating = false;
 
-    var self = this;
-    this._worker = new Worker('Connect4Worker.js');
-    this._worker.onmessage = function() { return self._onmessage.apply(self, arguments); };
-
-    this._postMessage('new', [settings]);
+    this._startWorker();
+    this._postMessage('new', [this._positionSettings()]);
     this.subscribe('gamestart', callback, context);
+    this._id = ++Connect4._lastId;
+    Connect4._games.push(this);
 
     return this;
 };
 
 /**
- * Drops the game piece in a given column for the given player. Publishes the movestart event at the beginning
- * of the move and publishes the moveend event once the move is finished.
+ * The settings used by the public API itself rather than by the game in the worker.
+ */
+Connect4.settings = {
+    defaults: {
+        autoConfigure: true,
+        workers: 2,
+        splitDepth: 2,
+        checkpointInterval: 60000,
+        moveDeadline: 2000,
+        deepLevel: 8,
+        degrade: true,
+        idleTimeout: 300000,
+        clock: null
+    }
+};
+
+/**
+ * Detects what the browser tells about the hardware: the number of logical cores and, in some browsers, the
+ * amount of memory in gigabytes. Physical cores and cache sizes are not exposed to pages, so they are not part of
+ * the picture.
  *
- * @param {number} player The player, 0 for player 1 and 1 for player 1.
- * @param {number} column The column to drop in starting from 0.
+ * @returns {object} An object with the following properties:
+ *                   logicalCores: the number of logical cores, 1 if unknown,
+ *                   memory: the memory in gigabytes, 0 if unknown.
+ */
+Connect4.hardware = function() {
+    var nav = typeof navigator !== 'undefined' ? navigator : {};
+
+    return {
+        logicalCores: nav.hardwareConcurrency || 1,
+        memory: nav.deviceMemory || 0
+    };
+};
+
+/**
+ * Picks settings for the hardware. One core is left to the page and the worker of each game, which only keep
+ * track of the moves, and the rest go to the shared pool (see Connect4.pool). With more workers than a two move
+ * split keeps busy, solves are split a move deeper. The tablebase block cache
+ * grows with the memory, at roughly 32 KB a block, and so does the main transposition table of each worker, at
+ * roughly 100 bytes a slot. The small transposition table stays at a size whose entries fit in a typical L2
+ * cache. Settings that are given are kept as they are.
  *
- * @throws moveInProgress If a move is currently in progress.
- * @throws gameOver If the game is over.
+ * @param {object} [settings] The settings given to the game.
+ *
+ * @returns {object} An object with the following properties:
+ *                   hardware: what was detected, see Connect4.hardware,
+ *                   settings: an object with an entry for each setting with its value and its source, either
+ *                             'detected' or 'given'.
  */
-Connect4.prototype.makeMove = function(player, column) {
-    if (this.moveInProgress) {
-        throw new Error('There is currently a move in progress');
-    } else if (this.gameOver) {
-        throw new Error('The game is over.');
+Connect4.configure = function(settings) {
+    settings = settings || {};
+
+    var hardware = Connect4.hardware(),
+        workers  = settings.workers !== undefined ? settings.workers : Math.max(1, hardware.logicalCores - 1),
+        picked   = {
+            workers: workers,
+            splitDepth: workers > 12 ? 3 : 2,
+            tablebaseCache: hardware.memory ? Math.max(16, Math.min(512, hardware.memory * 32)) : 64,
+            // a sixteenth of the memory shared by all the workers, in a power of two
+            tableSize: hardware.memory ?
+                Math.pow(2, Math.min(22, Math.floor(Math.log(hardware.memory * 671088 / (workers + 1)) / Math.LN2))) :
+                262144,
+            shallowTableSize: 4096
+        },
+        chosen   = {};
+
+    for (var key in picked) {
+        if (picked.hasOwnProperty(key)) {
+            chosen[key] = settings[key] !== undefined ?
+                { value: settings[key], source: 'given' } :
+                { value: picked[key], source: 'detected' };
+        }
     }
-    
-    this._moveStart(player);
-    this._postMessage('makeMove', arguments);
-    return this;
+
+    return { hardware: hardware, settings: chosen };
 };
 
 /**
- * Makes the move for the given player. Publishes the movestart event at the beginning
- * of the move and publishes the moveend event once the move is finished.
+ * Every game created on the page, so that metrics can be gathered across them.
+ * @private
+ */
+Connect4._games = [];
+
+/**
+ * The id of the last game created, the ids of closed games not being handed out again.
+ * @private
+ */
+Connect4._lastId = 0;
+
+/**
+ * The counters of the replicas and workers that are gone, closed or compacted, so that the counters of the
+ * metrics never go down.
+ * @private
+ */
+Connect4._retired = { searches: 0, solves: 0, nodes: 0, tablebaseHits: 0, tablebaseMisses: 0 };
+
+/**
+ * How many times games were compacted and brought back, see the idleTimeout setting.
+ * @private
+ */
+Connect4._compaction = { compactions: 0, rehydrations: 0 };
+
+/**
+ * The pool of workers shared by every game on the page.
+ * @private
+ */
+Connect4._pool = null;
+
+/**
+ * Gets the pool of workers shared by every game on the page, which runs the searches of autoMove and the jobs of
+ * solve. The pool is created on first use, with one worker per core but one unless another size is given.
  *
- * @param {number} player The player, 0 for player 1 and 1 for player 1.
- * @param {ai} [ai = settings.ai] The level of the AI, or how deep to search the game tree.
+ * @param {number} [size] The number of workers, only used when the pool is created.
  *
- * @throws moveInProgress If a move is currently in progress.
- * @throws gameOver If the game is over.
+ * @returns {Connect4Pool} The pool.
  */
-Connect4.prototype.autoMove = function(player, ai) {
-    if (this.moveInProgress) {
-        throw new Error('There is currently a move in progress');
-    } else if (this.gameOver) {
-        throw new Error('The game is over.');
+Connect4.pool = function(size) {
+    if (!Connect4._pool) {
+        Connect4._pool = new Connect4Pool(size || Math.max(1, Connect4.hardware().logicalCores - 1));
     }
-    
-    this._moveStart(player);
-    this._postMessage('autoMove', arguments);
-    return this;
+    return Connect4._pool;
 };
 
 /**
- * Subscribes to an event.
- *
- * @param {string} event The name of the event, all lowercase.
- * @param {function} handler The function to call when the event is published. Must be a named function to unsubscribe.
- * @param {object} [context = Connect4 instance] The context to call the function with.
+ * Closes the pool of workers shared by every game on the page, so that the next use creates a new one, of another
+ * size for instance. Tasks still queued or running are dropped without their callbacks being called, so this is
+ * best done while no game is moving or solving.
  */
-Connect4.prototype.subscribe = function(event, handler, context) {
-    this._subscribers[event] = this._subscribers[event] || [];
-    this._subscribers[event].push([handler, context]);
-    return this;
+Connect4.closePool = function() {
+    if (Connect4._pool) {
+        Connect4._pool.terminate();
+        Connect4._pool = null;
+        for (var i=0; i<Connect4._games.length; i++) {
+            delete Connect4._games[i]._poolWorker;
+        }
+    }
 };
 
 /**
- * Unsubscribe from an event.
+ * The overload policy. Moves are searched degradation levels less deep than asked for, and the degradation level
+ * goes up by one when the given percentile of the latencies of recent moves, as a share of their deadline, goes
+ * over high or the pool has more than queueHigh tasks queued per worker. It goes down by one once both have
+ * dropped below low and queueLow. The level changes at most once every interval milliseconds, and the latencies
+ * from before a change are forgotten so that the next decision is based on moves made at the new level.
+ */
+Connect4.overload = {
+    percentile: 0.9,
+    window: 50,
+    samples: 5,
+    high: 0.8,
+    low: 0.4,
+    queueHigh: 2,
+    queueLow: 0.5,
+    maxLevel: 3,
+    interval: 1000
+};
+
+/**
+ * The state of the overload policy: the degradation level, the recent latencies as shares of their deadlines
+ * and when the level last changed.
+ * @private
+ */
+Connect4._degradation = { level: 0, recent: [], changed: 0 };
+
+/**
+ * Applies the overload policy and returns the degradation level for a new move.
+ * @private
+ */
+Connect4._degrade = function() {
+    var policy  = Connect4.overload,
+        state   = Connect4._degradation,
+        pool    = Connect4.pool(),
+        now     = new Date().getTime(),
+        queue   = pool.queued() / pool.size,
+        recent  = state.recent.slice(0).sort(function(a, b) { return a - b; }),
+        latency = recent.length >= policy.samples ?
+            recent[Math.min(recent.length - 1, Math.floor(recent.length * policy.percentile))] : null;
+
+    if (now - state.changed < policy.interval) {
+        return state.level;
+    }
+
+    if (state.level < policy.maxLevel && ((latency !== null && latency > policy.high) || queue > policy.queueHigh)) {
+        state.level++;
+    }
+    else if (state.level > 0 && latency !== null && latency < policy.low && queue < policy.queueLow) {
+        state.level--;
+    }
+    else {
+        return state.level;
+    }
+
+    state.changed = now;
+    state.recent = [];
+    return state.level;
+};
+
+/**
+ * The latency histogram of moves made by autoMove, by level.
+ * @private
+ */
+Connect4._latency = {};
+
+/**
+ * The upper bounds, in seconds, of the buckets of the move latency histogram.
+ */
+Connect4.latencyBuckets = [0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10];
+
+/**
+ * Gets the metrics of every game on the page in the Prometheus text format, ready to be served or written to a
+ * file. Searches and nodes are counters, so the per second rates are left to the scraper. The counters of the
+ * workers come along with their replies, so this never has to wait for a search to finish.
  *
- * @param {string} event The name of the event, all lowercase.
- * @param {function} handler The function to call when the event is published. Must be a named function to unsubscribe.
- * @param {object} [context = Connect4 instance] The context to call the function with.
+ * @returns {string} The metrics.
  */
-Connect4.prototype.unsubscribe = function(event, handler, context) {
-    var index = this._subscribers[event].indexOf([handler, context]);
-    this._subscribers[event].slice(index, 1);
+Connect4.metrics = function() {
+    var searches = 0, solves = 0, nodes = 0, tablebaseHits = 0, tablebaseMisses = 0, active = 0, compacted = 0,
+        pool = Connect4._pool, queued = pool ? pool.queued() : 0, tables = {}, lines = [], samples,
+        workers = (pool ? pool.metrics() : []).concat([Connect4._retired]);
+
+    for (var i=0; i<Connect4._games.length; i++) {
+        workers.push(Connect4._games[i]._engineMetrics);
+        active += Connect4._games[i].gameOver ? 0 : 1;
+        compacted += Connect4._games[i].compacted ? 1 : 0;
+        queued += Connect4._games[i]._pending;
+        // the jobs of a solve are only handed to the pool once they are ready, see solve
+        queued += Connect4._games[i]._solveJob && Connect4._games[i]._solveJob.queue ?
+            Connect4._games[i]._solveJob.queue.length : 0;
+    }
+
+    for (var i=0; i<workers.length; i++) {
+        if (!workers[i]) { continue; }
+        searches += workers[i].searches;
+        solves += workers[i].solves;
+        nodes += workers[i].nodes;
+        tablebaseHits += workers[i].tablebaseHits || 0;
+        tablebaseMisses += workers[i].tablebaseMisses || 0;
+        for (var tier in workers[i].tables) {
+            if (!workers[i].tables.hasOwnProperty(tier)) { continue; }
+            var table = tables[tier] = tables[tier] || { size: 0, probes: 0, hits: 0, crossHits: 0, filled: 0 };
+            table.size += workers[i].tables[tier].size;
+            table.probes += workers[i].tables[tier].probes;
+            table.hits += workers[i].tables[tier].hits;
+            table.crossHits += workers[i].tables[tier].crossHits || 0;
+            table.filled += workers[i].tables[tier].filled;
+        }
+    }
+
+    Connect4._metric(lines, 'connect4_searches_total', 'counter', 'Moves searched by autoMove.', [['', searches]]);
+    Connect4._metric(lines, 'connect4_solves_total', 'counter', 'Solve jobs run.', [['', solves]]);
+    Connect4._metric(lines, 'connect4_nodes_total', 'counter', 'Positions searched.', [['', nodes]]);
+    Connect4._metric(lines, 'connect4_tablebase_cache_total', 'counter', 'Tablebase probes by block cache result.',
+        [['{result="hit"}', tablebaseHits], ['{result="miss"}', tablebaseMisses]]);
+    samples = [[], [], [], [], []];
+    for (var tier in tables) {
+        if (!tables.hasOwnProperty(tier)) { continue; }
+        samples[0].push(['{table="' + tier + '"}', tables[tier].probes]);
+        samples[1].push(['{table="' + tier + '"}', tables[tier].hits]);
+        samples[2].push(['{table="' + tier + '"}', tables[tier].filled / tables[tier].size]);
+        samples[3].push(['{table="' + tier + '"}', tables[tier].size]);
+        samples[4].push(['{table="' + tier + '"}', tables[tier].crossHits]);
+    }
+    Connect4._metric(lines, 'connect4_table_probes_total', 'counter', 'Transposition table lookups.', samples[0]);
+    Connect4._metric(lines, 'connect4_table_hits_total', 'counter', 'Transposition table lookups that hit.',
+        samples[1]);
+    Connect4._metric(lines, 'connect4_table_cross_hits_total', 'counter',
+        'Transposition table hits on entries stored by another game sharing the table.', samples[4]);
+    Connect4._metric(lines, 'connect4_table_fill_ratio', 'gauge', 'Share of transposition table slots in use.',
+        samples[2]);
+    Connect4._metric(lines, 'connect4_table_entries', 'gauge', 'Transposition table slots, a proxy for memory.',
+        samples[3]);
+    Connect4._metric(lines, 'connect4_queue_depth', 'gauge', 'Requests and solve jobs waiting on a worker.',
+        [['', queued]]);
+    Connect4._metric(lines, 'connect4_active_sessions', 'gauge', 'Games that are not over.', [['', active]]);
+    Connect4._metric(lines, 'connect4_compacted_sessions', 'gauge', 'Games compacted while idle.',
+        [['', compacted]]);
+    Connect4._metric(lines, 'connect4_compactions_total', 'counter', 'Idle games compacted.',
+        [['', Connect4._compaction.compactions]]);
+    Connect4._metric(lines, 'connect4_rehydrations_total', 'counter', 'Compacted games brought back.',
+        [['', Connect4._compaction.rehydrations]]);
+    Connect4._metric(lines, 'connect4_workers', 'gauge', 'Workers running.',
+        [['{kind="game"}', Connect4._games.length - compacted], ['{kind="pool"}', pool ? pool.size : 0]]);
+    samples = [];
+    for (var i=0; i<Connect4Pool.classes.length; i++) {
+        samples.push(['{class="' + Connect4Pool.classes[i] + '"}', pool && pool.missed[i] || 0]);
+    }
+    Connect4._metric(lines, 'connect4_deadline_misses_total', 'counter', 'Pool tasks finished after their deadline.',
+        samples);
+    Connect4._metric(lines, 'connect4_degradation_level', 'gauge',
+        'How many levels less autoMove searches because of overload.', [['', Connect4._degradation.level]]);
+    Connect4._metric(lines, 'connect4_coalesced_total', 'counter',
+        'Pool tasks that shared the result of another one in flight.', [['', pool ? pool.coalesced : 0]]);
+    Connect4._metric(lines, 'connect4_interleaved_total', 'counter',
+        'Pool tasks run in between two slices of another one.', [['', pool ? pool.interleaved : 0]]);
+    Connect4._metric(lines, 'connect4_failed_total', 'counter', 'Pool tasks that threw in the worker.',
+        [['', pool ? pool.failed : 0]]);
+
+    samples = [];
+    for (var level in Connect4._latency) {
+        if (!Connect4._latency.hasOwnProperty(level)) { continue; }
+        var histogram = Connect4._latency[level];
+        for (var i=0; i<Connect4.latencyBuckets.length; i++) {
+            samples.push(['_bucket{level="' + level + '",le="' + Connect4.latencyBuckets[i] + '"}',
+                histogram.buckets[i]]);
+        }
+        samples.push(['_bucket{level="' + level + '",le="+Inf"}', histogram.count]);
+        samples.push(['_sum{level="' + level + '"}', histogram.sum]);
+        samples.push(['_count{level="' + level + '"}', histogram.count]);
+    }
+    Connect4._metric(lines, 'connect4_move_duration_seconds', 'histogram',
+        'Time from requesting an autoMove to its result.', samples);
+
+    // only some browsers tell how much memory the page uses
+    if (typeof performance !== 'undefined' && performance.memory) {
+        Connect4._metric(lines, 'connect4_heap_bytes', 'gauge', 'JavaScript heap used by the page.',
+            [['', performance.memory.usedJSHeapSize]]);
+    }
+
+    return lines.join('\n') + '\n';
 };
 
 /**
- * Internal handle of movestart event.
+ * Adds the counters of a replica or worker that is going away to the retired ones. Table counters are not kept,
+ * they only cover the tables that are still around.
  * @private
  */
-Connect4.prototype._moveStart = function(player) {
-    this.moveInProgress = true;
-    this._publish('movestart', [player, this]);
+Connect4._retire = function(metrics) {
+    var retired = Connect4._retired;
+    if (metrics) {
+        retired.searches += metrics.searches;
+        retired.solves += metrics.solves;
+        retired.nodes += metrics.nodes;
+        retired.tablebaseHits += metrics.tablebaseHits || 0;
+        retired.tablebaseMisses += metrics.tablebaseMisses || 0;
+    }
 };
 
 /**
- * Internal handle of moveend event.
+ * Appends a metric with its help and type lines.
  * @private
  */
-Connect4.prototype._moveEnd = function(data) {
-    this.moveInProgress = false;
-    this._publish('moveend', [data.player, data.col, data.row, this]);
+Connect4._metric = function(lines, name, type, help, samples) {
+    lines.push('# HELP ' + name + ' ' + help);
+    lines.push('# TYPE ' + name + ' ' + type);
+    for (var i=0; i<samples.length; i++) {
+        lines.push(name + samples[i][0] + ' ' + samples[i][1]);
+    }
 };
 
 /**
- * Internal handle of gamestart event.
+ * Hashes a string to a 32 bit unsigned integer.
  * @private
  */
-Connect4.prototype._gameStart = function(game) {
-    this.columns = game._cols;
-    this.rows = game._rows;
-    this.connect = game._connect;
-    this._updateState(game.currentState);
-    this._publish('gamestart', [this]);
+Connect4._hash = function(string) {
+    var hash = 0;
+    for (var i=0, length=string.length; i<length; i++) {
+        hash = (hash * 31 + string.charCodeAt(i)) | 0;
+    }
+    return hash >>> 0;
 };
 
 /**
- * Updates the current state of the game.
+ * Adds a move to the latency histogram of its level.
  * @private
  */
-Connect4.prototype._updateState = function(currentState) {
-    for (var prop in currentState) {
-        if (currentState.hasOwnProperty(prop)) {
-            this[prop] = currentState[prop];
+Connect4._observeLatency = function(level, seconds) {
+    var histogram = Connect4._latency[level];
+    if (!histogram) {
+        histogram = Connect4._latency[level] = { buckets: [], sum: 0, count: 0 };
+        for (var i=0; i<Connect4.latencyBuckets.length; i++) {
+            histogram.buckets[i] = 0;
         }
     }
+
+    for (var i=0; i<Connect4.latencyBuckets.length; i++) {
+        if (seconds <= Connect4.latencyBuckets[i]) {
+            histogram.buckets[i]++;
+        }
+    }
+    histogram.sum += seconds;
+    histogram.count++;
 };
 
 /**
- * Fires an event and passes along any args.
- * @private
+ * Summarizes a search trace to show where move ordering went wrong. The worst ordered nodes are the ones that
+ * searched the most nodes in subtrees before the move that caused their cutoff, which a perfect ordering would
+ * have tried first. The largest subtrees are simply the nodes with the most nodes below them.
+ *
+ * @param {object} trace The trace as received by the trace event.
+ * @param {number} [count = 10] How many nodes to list in each category.
+ *
+ * @returns {object} An object with the following properties:
+ *                   nodes: the number of nodes in the trace,
+ *                   cutoffs: the number of nodes that had a cutoff,
+ *                   firstMoveCutoffs: the number of those where the cutoff came from the first move tried,
+ *                   worstOrdered: the worst ordered nodes, each with its key, depth, order (the columns tried),
+ *                                 cutoff (the index of the column that caused the cutoff), nodes (the size of its
+ *                                 subtree) and wasted (the nodes searched before the cutoff),
+ *                   largest: the largest subtrees, each with the same properties.
  */
-Connect4.prototype._publish = function(event, args) {
-    var index = 0, subscribers = this._subscribers[event] || [], subscriber;
-    while ((subscriber = subscribers[index++])) {
-        if (subscriber[0]) {
-            subscriber[0].apply(subscriber[1] || this, args);
+Connect4.summarizeTrace = function(trace, count) {
+    var nodes   = trace.nodes,
+        summary = [],
+        wasted  = [],
+        cutoffs = 0,
+        firsts  = 0;
+
+    count = count || 10;
+
+    // children come after their parent, so the nodes searched under the columns tried before the one that
+    // caused a cutoff can be added up in a single pass
+    for (var i=0; i<nodes.length; i++) {
+        var node = nodes[i], parent = nodes[node[1]];
+        wasted[i] = 0;
+        if (parent && parent[7] >= 0 && node[2] !== parent[6][parent[7]]) {
+            wasted[node[1]] += node[9];
+        }
+    }
+
+    for (var i=0; i<nodes.length; i++) {
+        var node = nodes[i];
+        if (node[7] >= 0) {
+            cutoffs++;
+            firsts += node[7] === 0 ? 1 : 0;
         }
+        summary.push({ key: node[0], depth: node[3], order: node[6], cutoff: node[7], nodes: node[9],
+            wasted: wasted[i] });
     }
+
+    return {
+        nodes: nodes.length,
+        cutoffs: cutoffs,
+        firstMoveCutoffs: firsts,
+        worstOrdered: summary.slice(0).sort(function(a, b) { return b.wasted - a.wasted; }).slice(0, count),
+        largest: summary.sort(function(a, b) { return b.nodes - a.nodes; }).slice(0, count)
+    };
 };
 
 /**
- * Handle receiving a message from the worker.
- * @private
+ * Carries a game on from a snapshot (see snapshot), on this page or another one. The moves are played in the new
+ * game's worker in one go rather than one by one, the clocks pick up where they were, and the table entries of
+ * the snapshot, if any, are loaded into a worker of the shared pool before the game starts so that its next
+ * search finds them.
+ *
+ * The moves can only be checked against the board in the worker. When one of them cannot be played there the
+ * restore is rejected: the game is closed and publishes the error event, with restore as the action, instead of
+ * gamestart.
+ *
+ * @param {object} snapshot The snapshot.
+ * @param {function} [callback] The callback to be called once the game is ready, in the position of the snapshot.
+ * @param {object} [context = Connect4 instance] The context for the callback.
+ *
+ * @returns {Connect4} The game.
+ *
+ * @throws An error if the snapshot is of another version or its moves are not written as snapshot writes them.
  */
-Connect4.prototype._onmessage = function(event) {
-    var data        = JSON.parse(event.data),
-        action      = data.action,
-        returnValue = data.returnValue;
-    
-    if (returnValue && returnValue.currentState) {
-        this._updateState(returnValue.currentState);
+Connect4.restore = function(snapshot, callback, context) {
+    if (snapshot.version !== Connect4.snapshotVersion) {
+        throw new Error('Not a snapshot of this version.');
     }
-    
-    switch (action) {
-        case 'autoMove':
-        case 'makeMove':
-            this._moveEnd(returnValue);
-            break;
-        case 'new':
-            this._gameStart(returnValue);
-            break;
-        case 'debug':
-            this._publish('debug', [data]);
-            break;
-        default:
-            this._publish(action, [returnValue]);
+    for (var i=0; i<snapshot.moves.length; i++) {
+        if (Connect4._digits.indexOf(snapshot.moves.charAt(i)) < 0) {
+            throw new Error('Not a valid move in the snapshot.');
+        }
     }
-    
-    if (this.gameOver) {
-        this._publish('gameend', [this]);
+
+    var game = new Connect4(snapshot.settings);
+    game._restoring = function() {
+        this._restoring = null;
+        this._idle();
+        if (this.clock && snapshot.clock) {
+            this.clock = snapshot.clock.slice(0);
+            this._clockStarted = new Date().getTime() - snapshot.clockRunning;
+        }
+        if (!snapshot.tables || !snapshot.tables.length) {
+            this._publish('gamestart', [this]);
+            return;
+        }
+        Connect4.pool().submit({
+            game: this,
+            action: 'importTable',
+            args: [snapshot.tables],
+            priority: Connect4Pool.INTERACTIVE,
+            // without the entries, which are only there to save work, the game still starts
+            callback: function() {
+                this._publish('gamestart', [this]);
+            }
+        });
+    };
+    game._moves = Connect4._decodeMoves(snapshot.moves);
+    game.subscribe('gamestart', callback, context);
+    return game;
+};
+
+/**
+ * The version of the snapshots taken by snapshot.
+ */
+Connect4.snapshotVersion = 1;
+
+/**
+ * The characters the moves of a snapshot are written with, one per move.
+ * @private
+ */
+Connect4._digits = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+
+/**
+ * Writes [player, column] moves one character each, the column times two plus the player, which covers boards
+ * of up to 32 columns.
+ * @private
+ */
+Connect4._encodeMoves = function(moves) {
+    var encoded = '';
+    for (var i=0; i<moves.length; i++) {
+        encoded += Connect4._digits.charAt(moves[i][1] * 2 + moves[i][0]);
     }
+    return encoded;
 };
 
 /**
- * Send a message to the worker.
+ * Reads the moves written by _encodeMoves.
  * @private
  */
-Connect4.prototype._postMessage = function(action, args) {
-    this._worker.postMessage(JSON.stringify({
-        action: action,
-        args: [].slice.call(args)
-    }));
-};
\ No newline at end of file
+Connect4._decodeMoves = function(encoded) {
+    var moves = [];
+    for (var i=0; i<encoded.length; i++) {
+        var digit = Connect4._digits.indexOf(encoded.charAt(i));
+        moves.push([digit & 1, digit >> 1]);
+    }
+    return moves;
+};
+
+/**
+ * Drops the game piece in a given column for the given player. Publishes the movestart event at the beginning
+ * of the move and publishes the moveend event once the move is finished.
+ *
+ * @param {number} player The player, 0 for player 1 and 1 for player 1.
+ * @param {number} column The column to drop in starting from 0.
+ *
+ * @throws moveInProgress If a move is currently in progress.
+ * @throws solveInProgress If a solve is currently in progress.
+ * @throws gameOver If the game is over.
+ */
+Connect4.prototype.makeMove = function(player, column) {
+    if (this.moveInProgress) {
+        throw new Error('There is currently a move in progress');
+    } else if (this.solveInProgress) {
+        throw new Error('There is currently a solve in progress');
+    } else if (this.gameOver) {
+        throw new Error('The game is over.');
+    }
+    
+    this._moveStart(player);
+    this._postMessage('makeMove', arguments);
+    return this;
+};
+
+/**
+ * Makes the move for the given player. Publishes the movestart event at the beginning
+ * of the move and publishes the moveend event once the move is finished. The search runs in the shared pool
+ * (see Connect4.pool) as an interactive task due moveDeadline milliseconds from now, ahead of any solve jobs.
+ * With the degrade setting the level is lowered, or the budget of a difficulty shrunk, while the page is
+ * overloaded, see Connect4.overload. When games with the same settings ask for a move in the same position at the
+ * same level, only one search is run for all of them. With the clock setting the time left on the player's clock
+ * decides how long the search takes, and a level only how deep it may go.
+ *
+ * A search deeper than the deepLevel setting that nothing else bounds can take many seconds, so it is a
+ * background task instead: the moves of other games get in between two of its slices rather than waiting for it.
+ *
+ * @param {number} player The player, 0 for player 1 and 1 for player 1.
+ * @param {number|string|object} [ai = settings.ai] The level of the AI, or how deep to search the game tree, or
+ *                                                 a difficulty as in the ai setting.
+ *
+ * @throws moveInProgress If a move is currently in progress.
+ * @throws solveInProgress If a solve is currently in progress.
+ * @throws gameOver If the game is over.
+ */
+Connect4.prototype.autoMove = function(player, ai) {
+    if (this.moveInProgress) {
+        throw new Error('There is currently a move in progress');
+    } else if (this.solveInProgress) {
+        throw new Error('There is currently a solve in progress');
+    } else if (this.gameOver) {
+        throw new Error('The game is over.');
+    }
+    
+    var reduce = this._settings.degrade ? Connect4._degrade() : 0,
+        clock  = this.clock && {
+            remaining: this.clock[player] - (new Date().getTime() - this._clockStarted),
+            increment: this._settings.clock.increment || 0
+        };
+
+    this._moveStart(player);
+    Connect4.pool().submit({
+        game: this,
+        action: 'searchMove',
+        args: [this._moves.slice(0), player, ai, reduce, clock],
+        key: [this._settingsKey, JSON.stringify(this.board), player, JSON.stringify(ai), reduce,
+              JSON.stringify(clock)].join(' '),
+        priority: this._isDeep(ai, clock) ? Connect4Pool.BACKGROUND : Connect4Pool.INTERACTIVE,
+        deadline: new Date().getTime() + this._settings.moveDeadline,
+        callback: function(result, task, error) {
+            if (error) {
+                this._fail('autoMove', error);
+                return;
+            }
+            this._searched = result;
+            this._postMessage('makeMove', [player, result.column]);
+        }
+    });
+    return this;
+};
+
+/**
+ * Tells whether an autoMove would search deeper than the deepLevel setting with nothing to cut it short: no
+ * difficulty or budget with nodes or time, no quota and no clock.
+ * @private
+ */
+Connect4.prototype._isDeep = function(ai, clock) {
+    var quota = this._quota || {};
+    ai = ai != null ? ai : (this._gameSettings.ai != null ? this._gameSettings.ai : 4);
+
+    if (clock || quota.nodes || quota.time || typeof ai === 'string') {
+        return false;
+    }
+    else if (ai !== null && typeof ai === 'object') {
+        return !ai.nodes && !ai.time && (ai.level != null ? ai.level : 20) > this._settings.deepLevel;
+    }
+    return ai > this._settings.deepLevel;
+};
+
+/**
+ * Solves the current position exactly, assuming the given player is to move. The game tree is split into jobs
+ * splitDepth moves deep and the jobs are handed out to the shared pool (see Connect4.pool) as they become ready,
+ * at most workers of them at a time. The results are
+ * combined with alpha-beta, so jobs handed out later are searched with the bounds found so far and jobs that can
+ * no longer change the outcome are never handed out at all.
+ *
+ * After every finished job the solveprogress event is published with an object with the following properties:
+ * completed: the number of jobs finished, remaining: the number of jobs that still matter, nodes: the number of
+ * positions searched, elapsed: the milliseconds spent so far and eta: the estimated milliseconds left based on the
+ * average time per finished job. Every checkpointInterval milliseconds the checkpoint event is published as well.
+ *
+ * The callback receives an object with the following properties:
+ * score: positive if the player can force a win, negative if the opponent can and 0 for a draw (see
+ *        Connect4Game#solve), column: the column to play to achieve the score, or -1 if the board is full,
+ * nodes: the number of positions searched by the jobs that finished, along with the ones of a resumed solve,
+ * truncated: whether the quota setting stopped the solve. The score is then only what the column is known to
+ *            achieve at least, and both are null and -1 when no column is known yet. A truncated solve also
+ *            comes with a checkpoint to resume it from, as checkpoint.
+ *
+ * With the quota setting the nodes and time of the quota are shared by the whole solve. Each job is handed its
+ * share, and the workers stop any job that goes over it.
+ *
+ * @param {number} player The player, 0 for player 1 and 1 for player 2.
+ * @param {function} callback The callback to be called with the result.
+ * @param {object} [context = Connect4 instance] The context for the callback.
+ *
+ * @throws moveInProgress If a move is currently in progress.
+ * @throws solveInProgress If a solve is currently in progress.
+ * @throws gameOver If the game is over.
+ */
+Connect4.prototype.solve = function(player, callback, context) {
+    if (this.gameOver) {
+        throw new Error('The game is over.');
+    }
+
+    return this._solve({
+        player: player,
+        moves: this._moves.slice(0),
+        splitDepth: this._settings.splitDepth,
+        results: [],
+        nodes: 0,
+        elapsed: 0
+    }, callback, context);
+};
+
+/**
+ * Resumes a solve from a checkpoint published by an earlier one, possibly by another instance of the game.
+ * The jobs finished before the checkpoint are not searched again. The game itself does not need to be in the
+ * position being solved.
+ *
+ * @param {object} checkpoint The checkpoint as received by the checkpoint event.
+ * @param {function} callback The callback to be called with the result (see solve).
+ * @param {object} [context = Connect4 instance] The context for the callback.
+ *
+ * @throws moveInProgress If a move is currently in progress.
+ * @throws solveInProgress If a solve is currently in progress.
+ */
+Connect4.prototype.resumeSolve = function(checkpoint, callback, context) {
+    return this._solve({
+        player: checkpoint.player,
+        moves: checkpoint.moves,
+        splitDepth: checkpoint.splitDepth,
+        results: checkpoint.results.slice(0),
+        nodes: checkpoint.nodes,
+        elapsed: checkpoint.elapsed
+    }, callback, context);
+};
+
+/**
+ * Counts the lines of play depth moves deep from the current position (perft), see Connect4Game#perft. The tree
+ * is split splitDepth moves deep and the parts are counted at once by every worker of the shared pool (see
+ * Connect4.pool) as background tasks, which run in slices so that the moves of games waiting on the pool get in
+ * between. A game that is already over is counted as a whole, as it has no moves to split. With unique, the
+ * positions depth moves deep are also counted once each: every part lists its own, and they are gathered on the
+ * page, so this takes memory in proportion to their number. The game may carry on in the meantime.
+ *
+ * The callback receives an object with the following properties:
+ * nodes, terminal, visited: as with Connect4Game#perft, visited not counting the positions the tree was split at,
+ * unique: with unique, the number of different positions depth moves deep, otherwise null,
+ * ms: the milliseconds it took,
+ * nodesPerSecond: the positions visited per second.
+ *
+ * @param {number} player The player to move, 0 for player 1 and 1 for player 2.
+ * @param {number} depth How many moves deep to count.
+ * @param {function} callback The callback to be called with the result.
+ * @param {object} [context = Connect4 instance] The context for the callback.
+ * @param {boolean} [unique = false] Whether to count the different positions as well.
+ */
+Connect4.prototype.perft = function(player, depth, callback, context, unique) {
+    var self    = this,
+        pool    = Connect4.pool(),
+        moves   = this._moves.slice(0),
+        started = new Date().getTime(),
+        result  = { nodes: 0, terminal: 0, visited: 0, unique: unique ? 0 : null },
+        keys    = {},
+        pending = 0,
+        failed  = false;
+
+    if (this.gameOver) {
+        pending = 1;
+        pool.submit({
+            game: this,
+            action: 'perft',
+            args: [player, depth, moves, unique],
+            callback: counted
+        });
+        return this;
+    }
+
+    pool.submit({
+        game: this,
+        action: 'frontier',
+        args: [player, Math.min(depth, this._settings.splitDepth), moves],
+        callback: function(frontier, task, error) {
+            if (error) {
+                return fail(error);
+            }
+            pending = frontier.length;
+            for (var i=0; i<frontier.length; i++) {
+                var path = frontier[i].path, line = moves.slice(0);
+                for (var j=0; j<path.length; j++) {
+                    line.push([j % 2 ? player ^ 1 : player, path[j]]);
+                }
+                pool.submit({
+                    game: self,
+                    action: 'perft',
+                    args: [path.length % 2 ? player ^ 1 : player, depth - path.length, line, unique],
+                    callback: counted
+                });
+            }
+        }
+    });
+
+    function counted(counts, task, error) {
+        if (error || failed) {
+            return fail(error);
+        }
+        result.nodes += counts.nodes;
+        result.terminal += counts.terminal;
+        result.visited += counts.visited;
+        for (var i=0; unique && i<counts.keys.length; i++) {
+            if (!keys.hasOwnProperty(counts.keys[i])) {
+                keys[counts.keys[i]] = true;
+                result.unique++;
+            }
+        }
+
+        if (--pending === 0) {
+            result.ms = new Date().getTime() - started;
+            result.nodesPerSecond = result.ms ? result.visited / result.ms * 1000 : 0;
+            callback.call(context || self, result);
+        }
+    }
+
+    // the counts of the other parts are of no use without this one
+    function fail(error) {
+        if (!failed) {
+            failed = true;
+            self._fail('perft', error);
+        }
+    }
+
+    return this;
+};
+
+/**
+ * Indexes an archive of games played on the board of this game by the positions they passed through: how many
+ * games passed through each position, with what results, which moves they went on with and which games they
+ * were. The games are replayed in chunks of Connect4Archive.chunkSize by the workers of the shared pool, in
+ * parallel and in slices as any background task (see Connect4Game#indexGames), and the chunks merged here. The callback receives the index, a plain
+ * object that survives JSON so it can be kept anywhere and queried later with Connect4Archive, and the
+ * milliseconds it took.
+ *
+ * @param {array} records The games as objects with the moves, written as in snapshot, and an id, a whole number
+ *                        that defaults to the place of the game in the list.
+ * @param {function} callback The callback to be called with the index.
+ * @param {object} [context = Connect4 instance] The context for the callback.
+ * @param {number} [depth] How many moves into each game to index, every position by default. Positions deep
+ *                         into a game are mostly reached by that game alone, so a shallow index is much smaller.
+ */
+Connect4.prototype.indexGames = function(records, callback, context, depth) {
+    var self    = this,
+        pool    = Connect4.pool(),
+        size    = Connect4Archive.chunkSize,
+        started = new Date().getTime(),
+        index   = { games: 0, skipped: [], positions: {} },
+        pending = Math.ceil(records.length / size),
+        failed  = false;
+
+    for (var i=0; i<records.length; i+=size) {
+        var games = [];
+        for (var j=i; j<Math.min(i + size, records.length); j++) {
+            games.push([records[j].id != null ? records[j].id : j, Connect4._decodeMoves(records[j].moves)]);
+        }
+        pool.submit({
+            game: this,
+            action: 'indexGames',
+            args: [games, depth],
+            callback: indexed
+        });
+    }
+
+    function indexed(part, task, error) {
+        // an index without some of the games would tell wrong counts, so one failed chunk fails them all
+        if (error || failed) {
+            !failed && self._fail('indexGames', error);
+            failed = true;
+            return;
+        }
+        Connect4Archive._merge(index, part);
+        if (--pending === 0) {
+            done();
+        }
+    }
+
+    function done() {
+        var settings = { cols: self.columns, rows: self.rows, connect: self.connect, depth: depth };
+        callback.call(context || self, Connect4Archive.build(settings, index), new Date().getTime() - started);
+    }
+
+    if (!pending) {
+        done();
+    }
+    return this;
+};
+
+/**
+ * Takes a snapshot of the game, from which Connect4.restore carries it on, on this page or another one. The
+ * snapshot is a plain object that survives JSON, with the following properties:
+ * version: see Connect4.snapshotVersion,
+ * settings: the settings of the game, including the ones picked by autoConfigure,
+ * moves: the moves played, one character each,
+ * clock and clockRunning: the clocks with the clock setting and how long the clock of the player to move has been
+ *                         running,
+ * tables: with the tables argument, the entries the game stored in the main transposition tables of the pool
+ *         workers that ran its searches, the most recent first (see Connect4Table#entries).
+ *
+ * @param {function} callback The callback to be called with the snapshot.
+ * @param {object} [context = Connect4 instance] The context for the callback.
+ * @param {number} [tables = 0] The most table entries to take from each pool worker.
+ *
+ * @throws moveInProgress If a move is currently in progress.
+ * @throws solveInProgress If a solve is currently in progress.
+ */
+Connect4.prototype.snapshot = function(callback, context, tables) {
+    if (this.moveInProgress) {
+        throw new Error('There is currently a move in progress');
+    } else if (this.solveInProgress) {
+        throw new Error('There is currently a solve in progress');
+    }
+
+    var self     = this,
+        pool     = Connect4._pool,
+        pending  = 1,
+        snapshot = {
+            version: Connect4.snapshotVersion,
+            settings: {},
+            moves: Connect4._encodeMoves(this._moves),
+            clock: this.clock && this.clock.slice(0),
+            clockRunning: this.clock ? new Date().getTime() - this._clockStarted : 0
+        };
+
+    for (var key in this._gameSettings) {
+        if (this._gameSettings.hasOwnProperty(key)) {
+            snapshot.settings[key] = this._gameSettings[key];
+        }
+    }
+    for (var key in this._settings) {
+        if (this._settings.hasOwnProperty(key)) {
+            snapshot.settings[key] = this._settings[key];
+        }
+    }
+    // what was picked for this hardware is given on the other end, where it may not be what would be picked
+    snapshot.settings.autoConfigure = false;
+
+    function done() {
+        if (--pending === 0) {
+            callback.call(context || self, snapshot);
+        }
+    }
+
+    if (tables && pool) {
+        snapshot.tables = [];
+        for (var i=0; i<pool.size; i++) {
+            if (!pool._workers[i].games[this._id]) { continue; }
+            pending++;
+            pool.submit({
+                game: this,
+                action: 'exportTable',
+                args: [tables],
+                affinity: i,
+                callback: function(entries) {
+                    snapshot.tables = snapshot.tables.concat(entries || []);
+                    done();
+                }
+            });
+        }
+    }
+    done();
+    return this;
+};
+
+/**
+ * Hands the game off to be carried on elsewhere: takes a snapshot as snapshot does and closes the game once it
+ * has it (see close). No moves should be made in the meantime, as they would not be part of the snapshot.
+ *
+ * @param {function} callback The callback to be called with the snapshot.
+ * @param {object} [context = Connect4 instance] The context for the callback.
+ * @param {number} [tables = 0] The most table entries to take from each pool worker.
+ *
+ * @throws moveInProgress If a move is currently in progress.
+ * @throws solveInProgress If a solve is currently in progress.
+ */
+Connect4.prototype.handoff = function(callback, context, tables) {
+    return this.snapshot(function(snapshot) {
+        this.close();
+        callback.call(context || this, snapshot);
+    }, this, tables);
+};
+
+/**
+ * Closes the game: its worker is terminated, the workers of the shared pool drop their replicas of it and it no
+ * longer counts among the games of the metrics. Tasks of the game still in the pool, such as a perft, run to the
+ * end first and the replicas are dropped after the last one. Nothing can be done with the game afterwards.
+ *
+ * @throws moveInProgress If a move is currently in progress.
+ * @throws solveInProgress If a solve is currently in progress.
+ */
+Connect4.prototype.close = function() {
+    if (this.moveInProgress) {
+        throw new Error('There is currently a move in progress');
+    } else if (this.solveInProgress) {
+        throw new Error('There is currently a solve in progress');
+    }
+
+    clearTimeout(this._idleTimer);
+    Connect4._retire(this._engineMetrics);
+    this._worker && this._worker.terminate();
+    this._closed = true;
+    Connect4._pool && !this._poolTasks && Connect4._pool.release(this);
+    Connect4._games.splice(Connect4._games.indexOf(this), 1);
+};
+
+/**
+ * Subscribes to an event.
+ *
+ * @param {string} event The name of the event, all lowercase.
+ * @param {function} handler The function to call when the event is published. Must be a named function to unsubscribe.
+ * @param {object} [context = Connect4 instance] The context to call the function with.
+ */
+Connect4.prototype.subscribe = function(event, handler, context) {
+    this._subscribers[event] = this._subscribers[event] || [];
+    this._subscribers[event].push([handler, context]);
+    return this;
+};
+
+/**
+ * Unsubscribe from an event.
+ *
+ * @param {string} event The name of the event, all lowercase.
+ * @param {function} handler The function to call when the event is published. Must be a named function to unsubscribe.
+ * @param {object} [context = Connect4 instance] The context to call the function with.
+ */
+Connect4.prototype.unsubscribe = function(event, handler, context) {
+    var index = this._subscribers[event].indexOf([handler, context]);
+    this._subscribers[event].slice(index, 1);
+};
+
+/**
+ * Internal handle of movestart event.
+ * @private
+ */
+Connect4.prototype._moveStart = function(player) {
+    this.moveInProgress = true;
+    this._moveStarted = new Date().getTime();
+    this._publish('movestart', [player, this]);
+};
+
+/**
+ * Internal handle of moveend event.
+ * @private
+ */
+Connect4.prototype._moveEnd = function(data) {
+    var searched = this._searched;
+
+    this._searched = null;
+    this.moveInProgress = false;
+    this.positionKey = data.positionKey;
+    if (searched) {
+        var elapsed = new Date().getTime() - this._moveStarted, recent = Connect4._degradation.recent;
+        this.truncated = !!searched.truncated;
+        Connect4._observeLatency(searched.level, elapsed / 1000);
+        recent.push(elapsed / this._settings.moveDeadline);
+        if (recent.length > Connect4.overload.window) {
+            recent.shift();
+        }
+    }
+    if (data.row >= 0) {
+        this._moves.push([data.player, data.col]);
+        this._chargeClock(data.player);
+    }
+    if (searched && searched.trace) {
+        this._publish('trace', [searched.trace, this]);
+    }
+    this._idle();
+    this._publish('moveend', [data.player, data.col, data.row, this]);
+};
+
+/**
+ * Stops the clock of the player who just moved, which starts the clock of the other one, and publishes the flag
+ * event if the player ran out of time. The increment is added after the move, as with a Fischer clock.
+ * @private
+ */
+Connect4.prototype._chargeClock = function(player) {
+    var now = new Date().getTime();
+
+    if (this.clock) {
+        this.clock[player] -= now - this._clockStarted;
+        if (this.clock[player] < 0) {
+            this._publish('flag', [player, this]);
+        }
+        this.clock[player] += this._settings.clock.increment || 0;
+    }
+    this._clockStarted = now;
+};
+
+/**
+ * Internal handle of gamestart event.
+ * @private
+ */
+Connect4.prototype._gameStart = function(game) {
+    this.columns = game._cols;
+    this.rows = game._rows;
+    this.connect = game._connect;
+    this.positionKey = game.positionKey;
+    this._clockStarted = new Date().getTime();
+    this._updateState(game.currentState);
+    if (this._restoring) {
+        // a restored game only starts once it is back in the position of its snapshot, see Connect4.restore
+        this._postMessage('loadMoves', [this._moves]);
+    }
+    else {
+        this._idle();
+        this._publish('gamestart', [this]);
+    }
+
+    if (this.configuration) {
+        this._publish('debug', [{
+            action: 'debug',
+            message: { action: 'configure', configuration: this.configuration }
+        }]);
+    }
+};
+
+/**
+ * Updates the current state of the game.
+ * @private
+ */
+Connect4.prototype._updateState = function(currentState) {
+    for (var prop in currentState) {
+        if (currentState.hasOwnProperty(prop)) {
+            this[prop] = currentState[prop];
+        }
+    }
+};
+
+/**
+ * Fires an event and passes along any args.
+ * @private
+ */
+Connect4.prototype._publish = function(event, args) {
+    var index = 0, subscribers = this._subscribers[event] || [], subscriber;
+    while ((subscriber = subscribers[index++])) {
+        if (subscriber[0]) {
+            subscriber[0].apply(subscriber[1] || this, args);
+        }
+    }
+};
+
+/**
+ * Handle receiving a message from the worker.
+ * @private
+ */
+Connect4.prototype._onmessage = function(event) {
+    var data        = JSON.parse(event.data),
+        action      = data.action,
+        returnValue = data.returnValue;
+
+    // every message other than debug ones answers one that was sent
+    if (action !== 'debug') {
+        this._pending--;
+        this._engineMetrics = data.metrics || this._engineMetrics;
+    }
+
+    if (data.error) {
+        this._rehydrating = false;
+        this._fail(this._restoring ? 'restore' : action, data.error);
+        return;
+    }
+
+    // the replies that bring a compacted game back only tell what the page already knows
+    if (this._rehydrating && (action === 'new' || action === 'loadMoves')) {
+        this._rehydrating = action === 'new';
+        return;
+    }
+    
+    if (returnValue && returnValue.currentState) {
+        this._updateState(returnValue.currentState);
+    }
+    
+    switch (action) {
+        case 'autoMove':
+        case 'makeMove':
+            this._moveEnd(returnValue);
+            break;
+        case 'new':
+            this._gameStart(returnValue);
+            break;
+        case 'loadMoves':
+            this.positionKey = returnValue.positionKey;
+            this._restoring();
+            break;
+        case 'debug':
+            this._publish('debug', [data]);
+            break;
+        default:
+            this._publish(action, [returnValue]);
+    }
+    
+    if (this.gameOver) {
+        this._publish('gameend', [this]);
+    }
+};
+
+/**
+ * Starts a solve from the given checkpoint, a fresh solve being a checkpoint without any results.
+ * @private
+ */
+Connect4.prototype._solve = function(checkpoint, callback, context) {
+    if (this.moveInProgress) {
+        throw new Error('There is currently a move in progress');
+    } else if (this.solveInProgress) {
+        throw new Error('There is currently a solve in progress');
+    }
+
+    this.solveInProgress = true;
+    this._solveJob = {
+        checkpoint: checkpoint,
+        player: checkpoint.player,
+        callback: callback,
+        context: context,
+        limit: this.columns * this.rows + 1,
+        token: Connect4Pool.token(),
+        running: [],
+        started: new Date().getTime(),
+        saved: new Date().getTime(),
+        quota: null
+    };
+
+    if (this._quota && (this._quota.nodes || this._quota.time)) {
+        this._solveJob.quota = {
+            nodes: (this._quota.nodes || Infinity) + checkpoint.nodes,
+            deadline: this._quota.time ? this._solveJob.started + this._quota.time : Infinity,
+            allocated: 0
+        };
+    }
+
+    Connect4.pool().submit({
+        game: this,
+        action: 'frontier',
+        args: [checkpoint.player, checkpoint.splitDepth, checkpoint.moves],
+        priority: Connect4Pool.BACKGROUND,
+        token: this._solveJob.token,
+        callback: function(frontier, task, error) {
+            error ? this._fail('solve', error) : this._solveStart(frontier);
+        }
+    });
+    return this;
+};
+
+/**
+ * Builds the tree of jobs for a solve from the frontier and starts handing them out.
+ * @private
+ */
+Connect4.prototype._solveStart = function(frontier) {
+    var job     = this._solveJob,
+        results = job.checkpoint.results,
+        root    = { children: {}, list: [], pending: 0, best: -job.limit, column: -1, player: job.player };
+
+    job.root = root;
+    job.queue = [];
+    job.nodes = {};
+    job.choice = 0;
+    job.check = null;
+
+    // turn the list of paths into a tree, each node knowing which player is to move there
+    for (var i=0; i<frontier.length; i++) {
+        var node = root, path = frontier[i].path;
+        for (var j=0; j<path.length; j++) {
+            if (!node.children[path[j]]) {
+                node.children[path[j]] = {
+                    children: {}, list: [], pending: 0, best: -job.limit, column: path[j],
+                    player: node.player ^ 1, parent: node
+                };
+                node.list.push(node.children[path[j]]);
+                node.first = node.first || node.children[path[j]];
+                node.pending++;
+            }
+            node = node.children[path[j]];
+        }
+        node.leaf = frontier[i];
+        job.queue.push(node);
+        job.nodes[path.join(',')] = node;
+    }
+
+    // lines that already ended the game need no job
+    for (var i=0; i<job.queue.length && !root.done; i++) {
+        if (job.queue[i].leaf.score !== undefined) {
+            this._solveResolve(job.queue[i], job.queue[i].leaf.score, false);
+        }
+    }
+
+    // replaying the results of a checkpoint in the order they came in rebuilds exactly the same windows
+    for (var i=0; i<results.length && !root.done; i++) {
+        this._solveResolve(job.nodes[results[i][0].join(',')], results[i][1], results[i][2]);
+    }
+
+    this._solveDispatch();
+};
+
+/**
+ * Hands the jobs that can still matter to the pool, as many at a time as the workers setting allows. As with
+ * young brothers wait, the later children of a node are held back until its first child is solved, so that
+ * they get a useful window.
+ * @private
+ */
+Connect4.prototype._solveDispatch = function() {
+    var job = this._solveJob;
+    if (!job || !job.root) {
+        return;
+    }
+    else if (job.root.done) {
+        // the only job left once the score is known is checking whether a column really achieves it
+        if (job.check && job.running.indexOf(job.check) < 0) {
+            this._solveSubmit(job.check, [-job.root.best - 1, -job.root.best + 1]);
+        }
+        return;
+    }
+
+    var left = this._solveQuotaLeft(), workers = this._solveWorkers();
+    if (left && (left.nodes < 1 || left.time < 1)) {
+        // jobs still running bring what is left of their share back, and if nothing is left the solve is over
+        job.running.length === 0 && this._solveEnd(this._solveBestColumn(), true);
+        return;
+    }
+
+    for (var i=0; i<job.queue.length && job.running.length < workers; i++) {
+        var node = job.queue[i];
+        if (node.leaf.score !== undefined || this._solveIsCut(node)) {
+            job.queue.splice(i--, 1);
+            continue;
+        }
+        else if (!this._solveIsReady(node)) {
+            continue;
+        }
+
+        job.queue.splice(i--, 1);
+        node.window = this._solveWindow(node);
+        this._solveSubmit(node, node.window);
+    }
+};
+
+/**
+ * Submits the job of a node to the pool.
+ * @private
+ */
+Connect4.prototype._solveSubmit = function(node, window) {
+    var job = this._solveJob, left = this._solveQuotaLeft(), limit = null;
+
+    // the nodes left are shared out between the jobs that can still run, so that together they stay within them
+    if (left) {
+        limit = {
+            nodes: Math.max(1, Math.floor(left.nodes / Math.max(1, this._solveWorkers() - job.running.length))),
+            time: Math.max(1, left.time)
+        };
+        node.allocated = limit.nodes;
+        job.quota.allocated += limit.nodes;
+    }
+
+    node.token = Connect4Pool.token(job.token);
+    job.running.push(node);
+
+    Connect4.pool().submit({
+        game: this,
+        action: 'solvePosition',
+        args: [this._solveMoves(node), node.player, window[0], window[1], limit],
+        priority: Connect4Pool.BACKGROUND,
+        token: node.token,
+        callback: function(result, task, error) {
+            error ? this._fail('solve', error) : this._solveResult(node, result);
+        }
+    });
+};
+
+/**
+ * Handles the result of a job.
+ * @private
+ */
+Connect4.prototype._solveResult = function(node, result) {
+    var job = this._solveJob;
+
+    job.running.splice(job.running.indexOf(node), 1);
+    job.quota && (job.quota.allocated -= node.allocated);
+
+    if (result.truncated) {
+        job.checkpoint.nodes += result.nodes;
+        this._solveEnd(this._solveBestColumn(), true);
+        return;
+    }
+    else if (node === job.check) {
+        job.checkpoint.nodes += result.nodes;
+        job.check = null;
+        // a score strictly inside the null window around the score is the score itself
+        if (-result.score === job.root.best) {
+            this._solveEnd(node.column);
+            return;
+        }
+        job.choice++;
+        this._solveChoose();
+    }
+    else if (!this._solveIsCut(node)) {
+        // a score at or above beta only bounds the real one
+        var bound = result.score >= node.window[1];
+        job.checkpoint.results.push([node.leaf.path, result.score, bound]);
+        job.checkpoint.nodes += result.nodes;
+        this._solveResolve(node, result.score, bound);
+        // the callback of a finished solve may already have started the next one
+        this._solveJob === job && this._solveProgress();
+    }
+
+    this._solveStopCut();
+    this._solveDispatch();
+};
+
+/**
+ * Cancels the jobs that no longer matter. The pool workers solve in slices, so they notice between two slices
+ * and are free for another job right away.
+ * @private
+ */
+Connect4.prototype._solveStopCut = function() {
+    var job = this._solveJob;
+    if (!job) {
+        return;
+    }
+
+    for (var i=0; i<job.running.length; i++) {
+        if (job.running[i] !== job.check && this._solveIsCut(job.running[i])) {
+            Connect4.pool().cancel(job.running[i].token);
+            // what a cancelled job searched is never reported, so its whole share counts as used
+            if (job.quota) {
+                job.quota.nodes -= job.running[i].allocated;
+                job.quota.allocated -= job.running[i].allocated;
+            }
+            job.running.splice(i--, 1);
+        }
+    }
+};
+
+/**
+ * Publishes the progress of the solve, and a checkpoint if one is due.
+ * @private
+ */
+Connect4.prototype._solveProgress = function() {
+    var job = this._solveJob;
+    if (!job) {
+        return;
+    }
+
+    var now        = new Date().getTime(),
+        checkpoint = job.checkpoint,
+        elapsed    = checkpoint.elapsed + now - job.started,
+        completed  = checkpoint.results.length,
+        remaining  = 0;
+
+    for (var i=0; i<job.queue.length; i++) {
+        if (!this._solveIsCut(job.queue[i])) {
+            remaining++;
+        }
+    }
+    remaining += job.running.length;
+
+    this._publish('solveprogress', [{
+        completed: completed,
+        remaining: remaining,
+        nodes: checkpoint.nodes,
+        elapsed: elapsed,
+        eta: Math.round(elapsed / completed * remaining)
+    }, this]);
+
+    if (now - job.saved >= this._settings.checkpointInterval) {
+        job.saved = now;
+        this._publish('checkpoint', [this._solveCheckpoint(), this]);
+    }
+};
+
+/**
+ * A checkpoint of the solve as it stands, see resumeSolve.
+ * @private
+ */
+Connect4.prototype._solveCheckpoint = function() {
+    var job = this._solveJob, checkpoint = job.checkpoint;
+
+    return {
+        player: checkpoint.player,
+        moves: checkpoint.moves,
+        splitDepth: checkpoint.splitDepth,
+        results: checkpoint.results.slice(0),
+        nodes: checkpoint.nodes,
+        elapsed: checkpoint.elapsed + new Date().getTime() - job.started
+    };
+};
+
+/**
+ * How many of the workers of the shared pool the solve may use at once.
+ * @private
+ */
+Connect4.prototype._solveWorkers = function() {
+    var quota = this._quota && this._quota.workers;
+    return Math.max(1, quota ? Math.min(quota, this._settings.workers) : this._settings.workers);
+};
+
+/**
+ * What is left of the quota of the solve that is not already handed out to running jobs, or null without one.
+ * @private
+ */
+Connect4.prototype._solveQuotaLeft = function() {
+    var job = this._solveJob, quota = job.quota;
+
+    return quota && {
+        nodes: quota.nodes - job.checkpoint.nodes - quota.allocated,
+        time: quota.deadline - new Date().getTime()
+    };
+};
+
+/**
+ * The best column found so far by a solve that has to stop early: the first in drop order of the columns whose
+ * score is known exactly and is the best known.
+ * @private
+ */
+Connect4.prototype._solveBestColumn = function() {
+    var root = this._solveJob.root;
+
+    for (var i=0; root && i<root.list.length; i++) {
+        if (root.list[i].done && !root.list[i].bound && -root.list[i].best === root.best) {
+            return root.list[i].column;
+        }
+    }
+    return -1;
+};
+
+/**
+ * Records the score of a node, from the point of view of the player to move there, and feeds it up the tree.
+ * A parent is resolved once all of its children are, or as soon as one of them produces a cutoff.
+ * @private
+ *
+ * @param {object} node The node.
+ * @param {number} score The score.
+ * @param {boolean} bound Whether the score is only a lower bound, having reached beta.
+ */
+Connect4.prototype._solveResolve = function(node, score, bound) {
+    node.done = true;
+    node.best = score;
+    node.bound = bound;
+
+    var parent = node.parent;
+    if (!parent) {
+        this._solveChoose();
+        return;
+    }
+    else if (parent.done) {
+        return;
+    }
+
+    if (-score > parent.best) {
+        parent.best = -score;
+    }
+
+    var cutoff = parent.best >= this._solveWindow(parent)[1];
+    if (--parent.pending === 0 || cutoff) {
+        this._solveResolve(parent, parent.best, cutoff);
+    }
+};
+
+/**
+ * Picks the column once the score is known. Which child first produced the score depends on the order the
+ * results came in, so instead the column is always the first one in drop order that achieves the score, no
+ * matter how many helpers there are or how long each job took. A child whose score is only a bound equal to the
+ * score might still achieve it, and is checked with a null window search before moving on to the next one.
+ * @private
+ */
+Connect4.prototype._solveChoose = function() {
+    var job = this._solveJob, root = job.root;
+
+    for (; job.choice<root.list.length; job.choice++) {
+        var node = root.list[job.choice];
+        if (-node.best !== root.best) {
+            continue;
+        }
+        else if (!node.bound) {
+            this._solveEnd(node.column);
+            return;
+        }
+
+        job.check = node;
+        this._solveDispatch();
+        return;
+    }
+
+    this._solveEnd(-1);
+};
+
+/**
+ * The moves leading to a node, from the position being solved.
+ * @private
+ */
+Connect4.prototype._solveMoves = function(node) {
+    var job = this._solveJob, path = [], player = job.player, moves = job.checkpoint.moves.slice(0);
+
+    for (; node.parent; node = node.parent) {
+        path.unshift(node.column);
+    }
+    for (var i=0; i<path.length; i++) {
+        moves.push([player, path[i]]);
+        player ^= 1;
+    }
+
+    return moves;
+};
+
+/**
+ * The alpha-beta window of a node given what is known so far about its ancestors.
+ * @private
+ */
+Connect4.prototype._solveWindow = function(node) {
+    if (!node.parent) {
+        return [-this._solveJob.limit, this._solveJob.limit];
+    }
+
+    var window = this._solveWindow(node.parent);
+    return [-window[1], -Math.max(window[0], node.parent.best)];
+};
+
+/**
+ * Checks whether every ancestor of a node has either solved its first child or has the node as its first child.
+ * @private
+ */
+Connect4.prototype._solveIsReady = function(node) {
+    for (; node.parent; node = node.parent) {
+        if (node.parent.first !== node && !node.parent.first.done) {
+            return false;
+        }
+    }
+    return true;
+};
+
+/**
+ * Checks whether a node or one of its ancestors has already been resolved, in which case the node no longer
+ * matters.
+ * @private
+ */
+Connect4.prototype._solveIsCut = function(node) {
+    for (; node; node = node.parent) {
+        if (node.done) {
+            return true;
+        }
+    }
+    return false;
+};
+
+/**
+ * Finishes a solve and calls its callback.
+ * @private
+ */
+Connect4.prototype._solveEnd = function(column, truncated) {
+    var job    = this._solveJob,
+        result = { score: job.root.best, column: column, nodes: job.checkpoint.nodes, truncated: !!truncated };
+
+    if (truncated) {
+        result.score = column >= 0 ? job.root.best : null;
+        result.checkpoint = this._solveCheckpoint();
+    }
+
+    this._solveJob = null;
+    this.solveInProgress = false;
+    Connect4.pool().cancel(job.token);
+    this._idle();
+
+    job.callback && job.callback.call(job.context || this, result);
+};
+
+/**
+ * Gives up whatever an action that failed in a worker was part of and publishes the error event.
+ * @private
+ */
+Connect4.prototype._fail = function(action, message) {
+    if (action === 'solve') {
+        // the other jobs of the solve may fail as well, once is enough
+        if (!this._solveJob) {
+            return;
+        }
+        Connect4.pool().cancel(this._solveJob.token);
+        this._solveJob = null;
+        this.solveInProgress = false;
+    }
+    else if (action === 'autoMove' || action === 'makeMove') {
+        this._searched = null;
+        this.moveInProgress = false;
+    }
+
+    // a game that cannot get to the position of its snapshot is of no use, see Connect4.restore
+    if (action === 'restore') {
+        this._restoring = null;
+        this.close();
+    }
+    else {
+        this._idle();
+    }
+    this._publish('error', [{ action: action, message: message }, this]);
+};
+
+/**
+ * Starts the worker of the game.
+ * @private
+ */
+Connect4.prototype._startWorker = function() {
+    var self = this;
+    this._worker = new Worker('Connect4Worker.js');
+    this._worker.onmessage = function() { return self._onmessage.apply(self, arguments); };
+};
+
+/**
+ * Restarts the wait after which the game is compacted, see the idleTimeout setting.
+ * @private
+ */
+Connect4.prototype._idle = function() {
+    var self = this;
+    clearTimeout(this._idleTimer);
+    this._idleTimer = this._settings.idleTimeout && !this.compacted ?
+        setTimeout(function() { self._compact(); }, this._settings.idleTimeout) : null;
+};
+
+/**
+ * Compacts the game down to its moves. A game that turns out to be busy waits another idleTimeout.
+ * @private
+ */
+Connect4.prototype._compact = function() {
+    if (this.moveInProgress || this.solveInProgress || this._pending || this._poolTasks) {
+        this._idle();
+        return;
+    }
+
+    this._idleTimer = null;
+    Connect4._retire(this._engineMetrics);
+    this._engineMetrics = null;
+    this._worker.terminate();
+    this._worker = null;
+    Connect4._pool && Connect4._pool.release(this);
+    this.compacted = true;
+    Connect4._compaction.compactions++;
+};
+
+/**
+ * Brings a compacted game back: a new worker is started and put back in the position of the game before any
+ * other message gets to it. The replicas in the pool come back on their own with the next task.
+ * @private
+ */
+Connect4.prototype._rehydrate = function() {
+    this._startWorker();
+    this.compacted = false;
+    this._rehydrating = true;
+    Connect4._compaction.rehydrations++;
+    this._postMessage('new', [this._positionSettings()]);
+    this._postMessage('loadMoves', [this._moves]);
+};
+
+/**
+ * The settings of the engine in the worker of the game. That engine only keeps the position, as the searches run
+ * in the pool, so it gets neither transposition tables nor the tablebase: they would take megabytes and a good
+ * part of a second to set up for nothing.
+ * @private
+ */
+Connect4.prototype._positionSettings = function() {
+    var settings = {};
+    for (var key in this._gameSettings) {
+        if (this._gameSettings.hasOwnProperty(key)) {
+            settings[key] = this._gameSettings[key];
+        }
+    }
+    settings.tableSize = 0;
+    settings.tablebase = null;
+    return settings;
+};
+
+/**
+ * Send a message to the worker.
+ * @private
+ */
+Connect4.prototype._postMessage = function(action, args) {
+    if (!this._worker) {
+        this._rehydrate();
+    }
+    this._pending++;
+    this._worker.postMessage(JSON.stringify({
+        action: action,
+        args: [].slice.call(args)
+    }));
+};
+/**
+ * A pool of workers shared by every game on the page, so that however many games there are and whatever they
+ * are doing the page never runs more searches at once than there are workers. Games hand it tasks: a method of
+ * the game to call in a worker, with its arguments. Each worker keeps a replica of every game it has run tasks
+ * for, so tasks carry the moves they need rather than relying on the state of the replica.
+ *
+ * Each worker has a queue of its own, kept in order of priority class and, within a class, earliest deadline
+ * first. A task goes to the queue of the worker named by its affinity, otherwise to the worker that last ran a
+ * task for the same game, whose tables already know the positions of that game, otherwise to the least loaded
+ * worker. A worker that runs out of tasks steals the most urgent task from the queues of the others, except for
+ * tasks that were given an affinity.
+ *
+ * Solves, move searches, perft and indexes of games run in slices of sliceNodes positions (see
+ * Connect4Pool.sliced) and only give way to other tasks between two slices, so a worker that runs one still takes
+ * a task of a higher class: the task runs in between two slices and the sliced one carries on after it. Long
+ * background work, or a deep autoMove, which runs in the background as well (see Connect4#autoMove), therefore
+ * never keeps an interactive move waiting for more than a slice. Any other task runs to its end once started.
+ *
+ * Tasks that are given a key are coalesced: a task submitted while another one with the same key is queued or
+ * running is attached to it rather than run again, and its callback gets the same result. The shared task is
+ * scheduled by the most urgent of the tasks attached to it, while each of them still counts against its own
+ * deadline.
+ *
+ * Tasks can be cancelled through tokens (see Connect4Pool.token). A cancelled task that is still queued is
+ * dropped and a running sliced task is stopped between two of its slices. The callback of a cancelled task is never
+ * called.
+ *
+ * @param {number} size The number of workers.
+ *
+ * @property {number} size The number of workers.
+ * @property {number} submitted The number of tasks submitted.
+ * @property {number} completed The number of tasks that finished and had their callback called.
+ * @property {number} failed The number of tasks that threw in the worker and had their callback called with the
+ *                           error.
+ * @property {number} cancelled The number of tasks that were cancelled.
+ * @property {number} stolen The number of tasks run by another worker than the one they were queued for.
+ * @property {number} interleaved The number of tasks run in between the slices of another one.
+ * @property {object} missed The number of tasks that finished after their deadline, by priority class.
+ * @property {number} coalesced The number of tasks attached to another one with the same key.
+ */
+function Connect4Pool(size) {
+    this.size = size;
+    this.submitted = 0;
+    this.completed = 0;
+    this.failed = 0;
+    this.cancelled = 0;
+    this.stolen = 0;
+    this.interleaved = 0;
+    this.missed = {};
+    this.coalesced = 0;
+
+    this._workers = [];
+    this._inflight = {};
+    this._lastTask = 0;
+    for (var i=0; i<size; i++) {
+        this._workers.push(this._createWorker(i));
+    }
+
+    return this;
+}
+
+/**
+ * The priority classes: background work such as solves and interactive work such as the moves of a game that
+ * someone is waiting on.
+ */
+Connect4Pool.BACKGROUND = 0;
+Connect4Pool.INTERACTIVE = 1;
+
+/**
+ * The names of the priority classes, as used in the metrics.
+ */
+Connect4Pool.classes = ['background', 'interactive'];
+
+/**
+ * The actions the workers run in slices, which can be stopped and let other tasks in between.
+ */
+Connect4Pool.sliced = { solvePosition: true, searchMove: true, perft: true, indexGames: true };
+
+/**
+ * Creates a cancellation token. Cancelling a token also cancels the tokens created with it as their parent, so
+ * a whole solve can be cancelled at once as well as any single one of its jobs.
+ *
+ * @param {object} [parent] The parent token.
+ *
+ * @returns {object} The token.
+ */
+Connect4Pool.token = function(parent) {
+    return { cancelled: false, parent: parent || null };
+};
+
+/**
+ * Checks whether a token or one of its parents has been cancelled.
+ *
+ * @param {object} token The token, or null.
+ *
+ * @returns {boolean} True if it has been cancelled.
+ */
+Connect4Pool.isCancelled = function(token) {
+    for (; token; token = token.parent) {
+        if (token.cancelled) {
+            return true;
+        }
+    }
+    return false;
+};
+
+/**
+ * Submits a task.
+ *
+ * @param {object} task The task, with the following properties:
+ *                      game: the Connect4 instance the task is for,
+ *                      action: the method of the game to call,
+ *                      args: the arguments,
+ *                      callback: the callback to be called with the return value and the task, and with a
+ *                                null return value and the error message as well if the task threw in the
+ *                                worker,
+ *                      context: the context for the callback, defaults to the game,
+ *                      priority: the priority class, higher classes run first, defaults to BACKGROUND,
+ *                      deadline: the time, in milliseconds since the epoch, the task should be done by, tasks of
+ *                                a class run earliest deadline first and the ones without a deadline last,
+ *                      affinity: the index of the worker to run on, which also keeps other workers from
+ *                                stealing the task,
+ *                      token: the cancellation token,
+ *                      key: what the result depends on, for tasks that can share a result.
+ *
+ * @returns {object} The task.
+ */
+Connect4Pool.prototype.submit = function(task) {
+    var workers = this._workers, index = task.affinity;
+
+    task.id = ++this._lastTask;
+    task.priority = task.priority || Connect4Pool.BACKGROUND;
+    task.deadline = task.deadline || Infinity;
+    task.token = task.token || null;
+    task.submitted = new Date().getTime();
+    task.followers = [];
+    // the priority and deadline of a task may be raised by the ones attached to it, but not what it asked for
+    task.requested = { priority: task.priority, deadline: task.deadline };
+
+    var leader = task.key !== undefined ? this._inflight[task.key] : undefined;
+    if (leader && !this._isCancelled(leader)) {
+        leader.followers.push(task);
+        this.submitted++;
+        this.coalesced++;
+        if (Connect4Pool._before(task, leader)) {
+            this._hurry(leader, task.priority, task.deadline);
+        }
+        return task;
+    }
+    else if (task.key !== undefined) {
+        this._inflight[task.key] = task;
+    }
+
+    if (index === undefined || index === null) {
+        index = task.game._poolWorker;
+        if (index === undefined) {
+            index = 0;
+            for (var i=1; i<workers.length; i++) {
+                if (this._load(workers[i]) < this._load(workers[index])) {
+                    index = i;
+                }
+            }
+        }
+    }
+
+    task.game._poolTasks++;
+    this._enqueue(workers[index % workers.length].queue, task);
+    this.submitted++;
+    this._run();
+    return task;
+};
+
+/**
+ * Cancels the tasks of a token and of every token created with it as their parent.
+ *
+ * @param {object} token The token.
+ */
+Connect4Pool.prototype.cancel = function(token) {
+    token.cancelled = true;
+
+    for (var i=0; i<this._workers.length; i++) {
+        var worker = this._workers[i];
+
+        for (var j=0; j<worker.queue.length; j++) {
+            if (this._isCancelled(worker.queue[j])) {
+                this._drop(worker.queue.splice(j--, 1)[0]);
+            }
+        }
+
+        // sliced tasks are stopped between two slices, anything else simply runs to the end and its result is
+        // dropped
+        var running = [worker.task, worker.interleaved];
+        for (j=0; j<running.length; j++) {
+            var task = running[j];
+            if (task && !task.stopping && Connect4Pool.sliced[task.action] && this._isCancelled(task)) {
+                task.stopping = true;
+                this._post(worker, 'stop', [], task.game, task.id);
+            }
+        }
+    }
+};
+
+/**
+ * Drops the replicas of a game from every worker, once the game is closed or compacted.
+ *
+ * @param {Connect4} game The game.
+ */
+Connect4Pool.prototype.release = function(game) {
+    for (var i=0; i<this._workers.length; i++) {
+        var worker = this._workers[i];
+        if (worker.games[game._id]) {
+            this._post(worker, 'drop', [], game);
+            Connect4._retire(worker.metrics[game._id]);
+            delete worker.games[game._id];
+            delete worker.metrics[game._id];
+        }
+    }
+};
+
+/**
+ * Terminates every worker, keeping the counters of their replicas for the metrics.
+ */
+Connect4Pool.prototype.terminate = function() {
+    for (var i=0; i<this._workers.length; i++) {
+        var worker = this._workers[i], tasks = worker.queue.concat(worker.task || [], worker.interleaved || []);
+        for (var j=0; j<tasks.length; j++) {
+            this._settle(tasks[j]);
+        }
+    }
+
+    for (var i=0; i<this._workers.length; i++) {
+        var worker = this._workers[i];
+        for (var id in worker.metrics) {
+            worker.metrics.hasOwnProperty(id) && Connect4._retire(worker.metrics[id]);
+        }
+        worker.worker.terminate();
+        worker.queue = [];
+        worker.task = worker.interleaved = null;
+        worker.games = {};
+        worker.metrics = {};
+    }
+    this._inflight = {};
+};
+
+/**
+ * Gets the number of tasks queued, not counting the ones running.
+ *
+ * @returns {number} The number of tasks.
+ */
+Connect4Pool.prototype.queued = function() {
+    var queued = 0;
+    for (var i=0; i<this._workers.length; i++) {
+        queued += this._workers[i].queue.length;
+    }
+    return queued;
+};
+
+/**
+ * Gets the counters piggybacked on the replies of the workers, one object per game replica. The replicas of a
+ * worker that share tables all report them, so only the latest report of each shared table is kept, with the
+ * replica that sent it.
+ *
+ * @returns {array} The counters.
+ */
+Connect4Pool.prototype.metrics = function() {
+    var metrics = [];
+    for (var i=0; i<this._workers.length; i++) {
+        var replicas = this._workers[i].metrics, latest = {};
+
+        for (var id in replicas) {
+            if (!replicas.hasOwnProperty(id) || !replicas[id].tableShare || !replicas[id].tables) { continue; }
+            var share = replicas[id].tableShare;
+            if (!latest[share] || latest[share].tables.deep.probes < replicas[id].tables.deep.probes) {
+                latest[share] = replicas[id];
+            }
+        }
+
+        for (var id in replicas) {
+            if (!replicas.hasOwnProperty(id)) { continue; }
+            var replica = replicas[id];
+            if (replica.tableShare && latest[replica.tableShare] !== replica) {
+                replica = {};
+                for (var key in replicas[id]) {
+                    key !== 'tables' && replicas[id].hasOwnProperty(key) && (replica[key] = replicas[id][key]);
+                }
+            }
+            metrics.push(replica);
+        }
+    }
+    return metrics;
+};
+
+/**
+ * Starts a worker.
+ * @private
+ */
+Connect4Pool.prototype._createWorker = function(index) {
+    var self   = this,
+        worker = { index: index, worker: new Worker('Connect4Worker.js'), queue: [], task: null, interleaved: null,
+                   games: {}, metrics: {} };
+
+    worker.worker.onmessage = function(event) {
+        self._onmessage(worker, JSON.parse(event.data));
+    };
+
+    return worker;
+};
+
+/**
+ * Handles a reply from a worker.
+ * @private
+ */
+Connect4Pool.prototype._onmessage = function(worker, data) {
+    var task = worker.interleaved && data.task === worker.interleaved.id ? worker.interleaved : worker.task;
+
+    // the counters of a replica that was dropped have been retired already
+    if (data.metrics && worker.games[data.game]) {
+        worker.metrics[data.game] = data.metrics;
+    }
+
+    // debug messages come from whatever the worker is running, and the task in between its slices is not
+    if (data.action === 'debug') {
+        (worker.interleaved || task) && (worker.interleaved || task).game._publish('debug', [data]);
+        return;
+    }
+    // the replies to new carry no task, and a stop that found nothing to stop came after the result
+    else if (!task || data.task !== task.id || (data.action === 'stop' && !data.returnValue.stopped)) {
+        return;
+    }
+
+    if (task === worker.interleaved) {
+        worker.interleaved = null;
+    }
+    else {
+        worker.task = null;
+    }
+
+    if (data.action === 'stop') {
+        this._drop(task);
+        this._run();
+        return;
+    }
+
+    // the task is no longer in flight, so the callbacks can submit the same key again
+    if (this._inflight[task.key] === task) {
+        delete this._inflight[task.key];
+    }
+    this._settle(task);
+
+    var members = [task].concat(task.followers), now = new Date().getTime();
+    for (var i=0; i<members.length; i++) {
+        var member = members[i];
+        if (Connect4Pool.isCancelled(member.token)) {
+            this.cancelled++;
+            continue;
+        }
+        if (now > member.requested.deadline) {
+            this.missed[member.requested.priority] = (this.missed[member.requested.priority] || 0) + 1;
+        }
+        data.error ? this.failed++ : this.completed++;
+        member.callback && member.callback.call(member.context || member.game, data.returnValue, member,
+            data.error);
+    }
+
+    this._run();
+};
+
+/**
+ * Hands the next task to every idle worker, from its own queue or else stolen from another one, and then lets
+ * what is left run in between the slices of the tasks running on the others.
+ * @private
+ */
+Connect4Pool.prototype._run = function() {
+    var worker, task, i;
+
+    for (i=0; i<this._workers.length; i++) {
+        worker = this._workers[i];
+        if (!worker.task && (task = this._next(worker))) {
+            worker.task = task;
+            this._start(worker, task);
+        }
+    }
+
+    // only then does a sliced task that is running let a task of a higher class in between two of its slices,
+    // sliced or not, so what is left is only what no idle worker can take: tasks bound to a busy worker. Such a
+    // task is for another game, except for a move search in between the slices of a solve: the search plays into
+    // a state of its own, anything else would find the game in the middle of the solve
+    for (i=0; i<this._workers.length; i++) {
+        worker = this._workers[i];
+        if (!worker.task || worker.interleaved || worker.task.stopping || !Connect4Pool.sliced[worker.task.action]) {
+            continue;
+        }
+
+        var running = worker.task;
+        if ((task = this._next(worker, function(task) {
+            return task.priority > running.priority && (task.game !== running.game ||
+                running.action === 'solvePosition' && task.action === 'searchMove');
+        }))) {
+            worker.interleaved = task;
+            this.interleaved++;
+            this._start(worker, task);
+        }
+    }
+};
+
+/**
+ * Sends a task to a worker, along with its game if the worker has no replica of it yet.
+ * @private
+ */
+Connect4Pool.prototype._start = function(worker, task) {
+    var id = task.game._id;
+    if (!worker.games[id]) {
+        worker.games[id] = true;
+        this._post(worker, 'new', [task.game._gameSettings], task.game);
+    }
+
+    task.game._poolWorker = worker.index;
+    this._post(worker, task.action, task.args, task.game, task.id);
+};
+
+/**
+ * Takes the next task for a worker off its own queue or, if there is none, steals the most urgent task without
+ * an affinity from the other queues. Only tasks accepted by the filter, if one is given, are considered.
+ * @private
+ */
+Connect4Pool.prototype._next = function(worker, filter) {
+    var victim = null, position = -1;
+
+    for (var i=-1; i<this._workers.length; i++) {
+        // the worker's own queue comes first
+        var other = i < 0 ? worker : this._workers[i], queue = other.queue;
+        if (i >= 0 && other === worker) {
+            continue;
+        }
+
+        for (var j=0; j<queue.length; j++) {
+            if (this._isCancelled(queue[j])) {
+                this._drop(queue.splice(j--, 1)[0]);
+            }
+            else if ((!filter || filter(queue[j])) && (other === worker ||
+                    queue[j].affinity === undefined || queue[j].affinity === null)) {
+                // queues are in order, so the first task that fits is the most urgent one of its queue
+                if (!victim || Connect4Pool._before(queue[j], victim.queue[position])) {
+                    victim = other;
+                    position = j;
+                }
+                break;
+            }
+        }
+
+        if (victim === worker) {
+            break;
+        }
+    }
+
+    if (!victim) {
+        return null;
+    }
+    else if (victim !== worker) {
+        this.stolen++;
+    }
+    return victim.queue.splice(position, 1)[0];
+};
+
+/**
+ * Inserts a task into a queue in order.
+ * @private
+ */
+Connect4Pool.prototype._enqueue = function(queue, task) {
+    var position = queue.length;
+    while (position > 0 && Connect4Pool._before(task, queue[position - 1])) {
+        position--;
+    }
+    queue.splice(position, 0, task);
+};
+
+/**
+ * Raises the priority and deadline of a task to those of a more urgent one attached to it, moving it up its
+ * queue if it is still waiting.
+ * @private
+ */
+Connect4Pool.prototype._hurry = function(task, priority, deadline) {
+    task.priority = Math.max(task.priority, priority);
+    task.deadline = Math.min(task.deadline, deadline);
+
+    for (var i=0; i<this._workers.length; i++) {
+        var queue = this._workers[i].queue, position = queue.indexOf(task);
+        if (position >= 0) {
+            queue.splice(position, 1);
+            this._enqueue(queue, task);
+        }
+    }
+};
+
+/**
+ * Checks whether a task and every task attached to it have been cancelled.
+ * @private
+ */
+Connect4Pool.prototype._isCancelled = function(task) {
+    if (!Connect4Pool.isCancelled(task.token)) {
+        return false;
+    }
+    for (var i=0; i<task.followers.length; i++) {
+        if (!Connect4Pool.isCancelled(task.followers[i].token)) {
+            return false;
+        }
+    }
+    return true;
+};
+
+/**
+ * Forgets a cancelled task along with the tasks attached to it.
+ * @private
+ */
+Connect4Pool.prototype._drop = function(task) {
+    if (this._inflight[task.key] === task) {
+        delete this._inflight[task.key];
+    }
+    this.cancelled += 1 + task.followers.length;
+    this._settle(task);
+};
+
+/**
+ * Counts a task as no longer queued or running, dropping the replicas of its game once the last task of a game
+ * closed in the meantime is done.
+ * @private
+ */
+Connect4Pool.prototype._settle = function(task) {
+    if (--task.game._poolTasks === 0 && task.game._closed) {
+        this.release(task.game);
+    }
+};
+
+/**
+ * Whether a task should run before another: higher classes first, then earlier deadlines, then the order they
+ * were submitted in.
+ * @private
+ */
+Connect4Pool._before = function(task, other) {
+    if (task.priority !== other.priority) {
+        return task.priority > other.priority;
+    }
+    else if (task.deadline !== other.deadline) {
+        return task.deadline < other.deadline;
+    }
+    return task.id < other.id;
+};
+
+/**
+ * The number of tasks queued for or running on a worker.
+ * @private
+ */
+Connect4Pool.prototype._load = function(worker) {
+    return worker.queue.length + (worker.task ? 1 : 0) + (worker.interleaved ? 1 : 0);
+};
+
+/**
+ * Sends a message to a worker, for the replica of the given game.
+ * @private
+ */
+Connect4Pool.prototype._post = function(worker, action, args, game, task) {
+    worker.worker.postMessage(JSON.stringify({
+        action: action,
+        args: [].slice.call(args),
+        game: game._id,
+        task: task
+    }));
+};
+
+/**
+ * Queries an index of an archive of games, as built by Connect4#indexGames, by position: how many games passed
+ * through it, with what results, which moves they went on with and which games they were. The index is a plain
+ * object with the following properties:
+ * version: see Connect4Archive.version,
+ * cols, rows, connect: the geometry of the board,
+ * depth: how many moves into each game were indexed, null for all of them,
+ * games: the number of games indexed,
+ * skipped: the ids of the games left out for a move that is not valid,
+ * keys: the canonical keys of the positions (see Connect4Game#positionKey), sorted,
+ * stats: four numbers for each key in turn: the games, the wins of player 1, the wins of player 2 and the draws,
+ * next: for each key, the moves played next as the column followed by the same four numbers, the most played
+ *       first, with the columns of the position of the key,
+ * ids: for each key, the ids of the games, sorted and written as in Connect4Archive._encodeIds.
+ *
+ * Nothing is unpacked up front: a lookup is a binary search of the keys, and only the ids of the position found
+ * are decoded, and only when asked for, so an index is ready to query as soon as it is loaded.
+ *
+ * @param {object} index The index.
+ *
+ * @property {number} lookups The number of lookups.
+ * @property {number} hits The number of lookups that found their position.
+ *
+ * @throws An error if the index is of another version.
+ */
+function Connect4Archive(index) {
+    if (index.version !== Connect4Archive.version) {
+        throw new Error('Not an archive index of this version.');
+    }
+
+    this._index = index;
+    this.lookups = 0;
+    this.hits = 0;
+
+    return this;
+}
+
+/**
+ * The version of the indexes built by Connect4#indexGames.
+ */
+Connect4Archive.version = 1;
+
+/**
+ * The number of games each task of Connect4#indexGames replays.
+ */
+Connect4Archive.chunkSize = 500;
+
+/**
+ * Looks up a position by its canonical key, as in the positionKey property of a game.
+ *
+ * @param {string} key The key.
+ * @param {boolean} [ids = false] Whether to decode the ids of the games as well.
+ *
+ * @returns {object} An object with the following properties, or null if no game passed through the position:
+ *                   key: the key,
+ *                   games, wins, draws, unfinished: the number of games, the wins of each player as an array, the
+ *                                                   draws and the games that did not end,
+ *                   next: the moves played next, the most played first, as objects with the column, in the
+ *                         position of the key, and the same games, wins, draws and unfinished,
+ *                   ids: with ids, the ids of the games, sorted.
+ */
+Connect4Archive.prototype.lookup = function(key, ids) {
+    var index = this._index, found = this._find(key);
+
+    this.lookups++;
+    if (found < 0) {
+        return null;
+    }
+    this.hits++;
+
+    var position = Connect4Archive._stats(index.stats, found * 4),
+        next     = index.next[found];
+
+    position.key = key;
+    position.next = [];
+    for (var i=0; i<next.length; i+=5) {
+        var move = Connect4Archive._stats(next, i + 1);
+        move.column = next[i];
+        position.next.push(move);
+    }
+    if (ids) {
+        position.ids = Connect4Archive._decodeIds(index.ids[found]);
+    }
+    return position;
+};
+
+/**
+ * Looks up the position after a line of play, the opening explorer way: the moves played next come with the
+ * columns of the position the line leads to rather than of its canonical key. In a position that is its own
+ * mirror image a move and its mirror image count as one, under the lower of the two columns.
+ *
+ * @param {array|string} moves The moves from the empty board, as [player, column] pairs or written as in
+ *                             Connect4#snapshot.
+ * @param {boolean} [ids = false] Whether to decode the ids of the games as well.
+ *
+ * @returns {object} The position, as with lookup.
+ */
+Connect4Archive.prototype.explore = function(moves, ids) {
+    var line     = typeof moves === 'string' ? Connect4._decodeMoves(moves) : moves,
+        key      = Connect4Archive._key(line, this._index.cols),
+        position = this.lookup(key.key, ids);
+
+    for (var i=0; position && key.mirrored && i<position.next.length; i++) {
+        position.next[i].column = this._index.cols - 1 - position.next[i].column;
+    }
+    return position;
+};
+
+/**
+ * Gets the statistics of the lookups.
+ *
+ * @returns {object} The number of positions and games in the index and the counters described in the
+ *                   constructor.
+ */
+Connect4Archive.prototype.stats = function() {
+    return {
+        positions: this._index.keys.length,
+        games: this._index.games,
+        lookups: this.lookups,
+        hits: this.hits
+    };
+};
+
+/**
+ * Builds an index from the merged counts of Connect4Game#indexGames.
+ *
+ * @param {object} settings The geometry of the board, cols, rows and connect, and the depth indexed.
+ * @param {object} counts The counts: games, skipped and positions as returned by Connect4Game#indexGames.
+ *
+ * @returns {object} The index.
+ */
+Connect4Archive.build = function(settings, counts) {
+    var index = {
+        version: Connect4Archive.version,
+        cols: settings.cols,
+        rows: settings.rows,
+        connect: settings.connect,
+        depth: settings.depth != null ? settings.depth : null,
+        games: counts.games,
+        skipped: counts.skipped.slice(0).sort(function(a, b) { return a - b; }),
+        keys: [],
+        stats: [],
+        next: [],
+        ids: []
+    };
+
+    for (var key in counts.positions) {
+        counts.positions.hasOwnProperty(key) && index.keys.push(key);
+    }
+    // the same order as the < of the binary search
+    index.keys.sort();
+
+    for (var i=0; i<index.keys.length; i++) {
+        var position = counts.positions[index.keys[i]], columns = [], next = [];
+
+        index.stats.push.apply(index.stats, position.stats);
+
+        for (var column in position.next) {
+            position.next.hasOwnProperty(column) && columns.push(+column);
+        }
+        columns.sort(function(a, b) { return position.next[b][0] - position.next[a][0] || a - b; });
+        for (var j=0; j<columns.length; j++) {
+            next.push(columns[j]);
+            next.push.apply(next, position.next[columns[j]]);
+        }
+        index.next.push(next);
+
+        index.ids.push(Connect4Archive._encodeIds(position.ids.sort(function(a, b) { return a - b; })));
+    }
+
+    return index;
+};
+
+/**
+ * Adds the counts of one chunk of games, as returned by Connect4Game#indexGames, to the counts of the others.
+ * @private
+ */
+Connect4Archive._merge = function(counts, part) {
+    counts.games += part.games;
+    counts.skipped.push.apply(counts.skipped, part.skipped);
+
+    for (var key in part.positions) {
+        if (!part.positions.hasOwnProperty(key)) { continue; }
+        var from = part.positions[key], to = counts.positions[key];
+
+        if (!counts.positions.hasOwnProperty(key)) {
+            counts.positions[key] = from;
+            continue;
+        }
+        for (var i=0; i<4; i++) {
+            to.stats[i] += from.stats[i];
+        }
+        to.ids.push.apply(to.ids, from.ids);
+        for (var column in from.next) {
+            if (!from.next.hasOwnProperty(column)) { continue; }
+            if (!to.next[column]) {
+                to.next[column] = from.next[column];
+                continue;
+            }
+            for (var i=0; i<4; i++) {
+                to.next[column][i] += from.next[column][i];
+            }
+        }
+    }
+};
+
+/**
+ * Turns four numbers of an index, the games, the wins of each player and the draws, into an object.
+ * @private
+ */
+Connect4Archive._stats = function(numbers, offset) {
+    var games = numbers[offset], wins = [numbers[offset + 1], numbers[offset + 2]], draws = numbers[offset + 3];
+    return { games: games, wins: wins, draws: draws, unfinished: games - wins[0] - wins[1] - draws };
+};
+
+/**
+ * Finds the place of a key in the sorted keys of the index.
+ * @private
+ *
+ * @returns {number} The place of the key or -1 if it is not there.
+ */
+Connect4Archive.prototype._find = function(key) {
+    var keys = this._index.keys, low = 0, high = keys.length - 1;
+
+    while (low <= high) {
+        var middle = (low + high) >> 1;
+        if (keys[middle] < key) {
+            low = middle + 1;
+        }
+        else if (keys[middle] > key) {
+            high = middle - 1;
+        }
+        else {
+            return middle;
+        }
+    }
+    return -1;
+};
+
+/**
+ * Gets the canonical key of the position after a line of play, and whether it was taken from the mirror image.
+ * It must give the key Connect4Game#_positionKey gives for the same position, which is where the key is defined.
+ * @private
+ */
+Connect4Archive._key = function(moves, cols) {
+    var columns = [];
+
+    for (var i=0; i<cols; i++) {
+        columns[i] = '';
+    }
+    for (var i=0; i<moves.length; i++) {
+        columns[moves[i][1]] += moves[i][0];
+    }
+
+    var key = columns.join('|'), mirror = columns.reverse().join('|');
+    return { key: mirror < key ? mirror : key, mirrored: mirror < key };
+};
+
+/**
+ * Writes sorted ids as the differences between them, each a run of characters of Connect4._digits holding five
+ * bits, the lowest first, with the sixth bit set on all but the last. Ids close together, as the ones of games
+ * indexed together tend to be, take a character each.
+ * @private
+ */
+Connect4Archive._encodeIds = function(ids) {
+    var encoded = '', last = 0;
+
+    for (var i=0; i<ids.length; i++) {
+        var delta = ids[i] - last;
+        last = ids[i];
+        while (delta >= 32) {
+            encoded += Connect4._digits.charAt(32 | (delta % 32));
+            delta = Math.floor(delta / 32);
+        }
+        encoded += Connect4._digits.charAt(delta);
+    }
+    return encoded;
+};
+
+/**
+ * Reads the ids written by _encodeIds.
+ * @private
+ */
+Connect4Archive._decodeIds = function(encoded) {
+    var ids = [], last = 0, delta = 0, scale = 1;
+
+    for (var i=0; i<encoded.length; i++) {
+        var digit = Connect4._digits.indexOf(encoded.charAt(i));
+        delta += (digit & 31) * scale;
+        if (digit & 32) {
+            scale *= 32;
+            continue;
+        }
+        last += delta;
+        ids.push(last);
+        delta = 0;
+        scale = 1;
+    }
+    return ids;
+};
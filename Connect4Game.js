@@ -50,7 +50,9 @@ function Connect4Game(settings) {
         this['_'+key] = setting !== undefined ? setting : Connect4Game.settings.defaults[key];
     }
 
-    this._ai = Math.max(0, Math.min(this._ai, 20)); // make sure ai level is within bounds
+    if (this._budgetOf(this._ai) === null) {
+        this._ai = Math.max(0, Math.min(this._ai, 20)); // make sure ai level is within bounds
+    }
 
     this._none = -1;
     this._magicWinningNumber = 1 << this._connect;
@@ -70,6 +72,64 @@ function Connect4Game(settings) {
 
     this.currentState = this._stateStack[0];
 
+    this._metrics = {
+        searches: 0,
+        solves: 0,
+        nodes: 0
+    };
+
+    // the solve in progress, see startSolve
+    this._search = null;
+
+    // the budget of the search in progress, see _budgetStart
+    this._budget = null;
+
+    // the search of searchMove in progress, see startSearch
+    this._moveSearch = null;
+
+    // the count of perft in progress, see startPerft
+    this._perftRun = null;
+
+    // the index of games in progress, see startIndex
+    this._indexRun = null;
+
+    // a quota on table memory shrinks both tables alike
+    var slots = this._tableSize + this._shallowTableSize;
+    if (this._quota && this._quota.tableSize != null && slots > this._quota.tableSize) {
+        var share = this._quota.tableSize / slots;
+        this._tableSize = Math.floor(this._tableSize * share);
+        this._shallowTableSize = Math.floor(this._shallowTableSize * share);
+    }
+
+    // games that would store the same values for the same positions can share their tables, which a tablebase
+    // rules out as it settles positions the search would otherwise have to value
+    this._session = ++Connect4Game._sessions;
+    this._tableShare = this._shareTables && this._tableSize > 0 && !this._tablebase ?
+        [this._cols, this._rows, this._connect, this._tableSize, this._shallowTableSize].join(' ') : null;
+
+    var tables = this._tableShare !== null && Connect4Game._sharedTables[this._tableShare];
+    if (!tables) {
+        // nodes close to the leaves are many but cheap to redo, so they get a small table of their own rather
+        // than pushing the expensive ones out of the large one
+        tables = { deep: this._tableSize > 0 ? new Connect4Table(this._tableSize, 'depth') : null };
+        tables.shallow = this._tableSize > 0 && this._shallowTableSize > 0 ?
+            new Connect4Table(this._shallowTableSize, 'always') : tables.deep;
+        if (this._tableShare !== null) {
+            Connect4Game._sharedTables[this._tableShare] = tables;
+        }
+    }
+    this._deepTable = tables.deep;
+    this._shallowTable = tables.shallow;
+
+    this._tablebaseReader = null;
+    if (this._tablebase) {
+        if (this._tablebase.cols !== this._cols || this._tablebase.rows !== this._rows ||
+                this._tablebase.connect !== this._connect) {
+            throw new Error('The tablebase is for a different board.');
+        }
+        this._tablebaseReader = new Connect4Tablebase(this._tablebase, this._tablebaseCache);
+    }
+
     this._setupBoard();
     this._setupPlayerStats();
     this._setupMap();
@@ -86,10 +146,84 @@ Connect4Game.settings = {
         cols: 7,
         rows: 6,
         connect: 4,
-        ai: 4
+        ai: 4,
+        book: null,
+        trace: false,
+        tablebase: null,
+        tablebaseCache: 64,
+        sliceNodes: 2000,
+        tableSize: 262144,
+        shallowTableSize: 4096,
+        shallowDepth: 2,
+        seed: null,
+        quota: null,
+        shareTables: true
     }
 };
 
+/**
+ * The difficulties that can be given instead of a level, see autoMove. Each is a budget: the number of positions
+ * (nodes) or milliseconds (time) a move may search, whichever runs out first, and how far below the best move, in
+ * the goodness of the evaluation, a move may be and still get picked at random (margin). They are budgets of
+ * positions rather than time so that they play the same on any hardware and with the seed setting. A budget may
+ * also have the deepest level to search as level, and a clock: the remaining time and the increment of a Fischer
+ * clock in milliseconds, as remaining and increment, from which the search works out how long the move may take,
+ * see Connect4Game.clock.
+ *
+ * The budgets were matched to the levels by playing them against each other, and each preset is about as strong
+ * as the level in its comment. Their margins make the lower ones a little erratic, as a person would be.
+ */
+Connect4Game.difficulties = {
+    beginner: { nodes: 100, margin: 4 },   // level 3
+    casual:   { nodes: 600, margin: 2 },   // level 5
+    club:     { nodes: 3000, margin: 0 },  // level 7
+    expert:   { nodes: 15000, margin: 0 }  // level 9
+};
+
+/**
+ * How a clock is turned into time for a move, see autoMove. All times are in milliseconds.
+ * reserve: the time always left on the clock, for the moves to get to and from the worker,
+ * increment: the share of the increment added to the soft limit,
+ * hard: how many soft limits the hard limit is at most,
+ * share: the share of the time left the hard limit is at most,
+ * instability: how much the soft limit grows each time the best move changes,
+ * dominance: how much better than every other move, in goodness, a move has to be to stop early,
+ * stable: for how many levels in a row it has to have been the best move.
+ */
+Connect4Game.clock = {
+    reserve: 100,
+    increment: 0.75,
+    hard: 4,
+    share: 0.25,
+    instability: 1.5,
+    dominance: 8,
+    stable: 2
+};
+
+/**
+ * About how many times more positions a search one level deeper takes, which is how much the budget of a
+ * difficulty shrinks for every level the page asks to search less, see searchMove.
+ */
+Connect4Game.levelCost = 3;
+
+/**
+ * The transposition tables shared by the games of this worker, by the board and table sizes they are for. See
+ * the shareTables setting.
+ * @private
+ */
+Connect4Game._sharedTables = {};
+
+/**
+ * The number of games created in this worker, which gives each its tag in shared tables.
+ * @private
+ */
+Connect4Game._sessions = 0;
+
+/**
+ * The fields of each node in a search trace, in order.
+ */
+Connect4Game.traceFields = ['key', 'parent', 'column', 'depth', 'alpha', 'beta', 'order', 'cutoff', 'score', 'size'];
+
 /**
  * This function returns the "score" of the specified player. This score is a function of how many winning
  * positions are still available to the player and how close he/she is to achieving each of these positions.
@@ -152,6 +286,7 @@ Connect4Game.prototype.makeMove = function(player, column) {
         col: column,
         row: this._dropPiece(player, column),
         player: player,
+        positionKey: this.positionKey(),
         currentState: this.currentState
     };
 
@@ -163,247 +298,1778 @@ Connect4Game.prototype.makeMove = function(player, column) {
 };
 
 /**
- * Makes the best possible move for the given player assuming the other player makes the best possible moves.
+ * Plays the given moves in one go, as when a game is restored from a snapshot.
  *
- * @param {number} player The player, 0 for player 1 and 1 for player 1.
- * @param {number} ai The level of the AI, or how deep to search the game tree.
+ * @param {array} moves The moves as [player, column] pairs.
+ *
+ * @returns {object} An object with the positionKey and currentState after the moves.
+ *
+ * @throws An error if one of the moves is not valid, in which case the moves before it stay played.
  */
-Connect4Game.prototype.autoMove = function(player, ai) {
-    var bestColumn = -1,
-        goodness   = 0,
-        bestWorst  = -(Number.MAX_VALUE);
+Connect4Game.prototype.loadMoves = function(moves) {
+    for (var i=0; i<moves.length; i++) {
+        if (moves[i][1] >= this._cols || moves[i][1] < 0 || this._dropPiece(moves[i][0], moves[i][1]) < 0) {
+            throw new Error('Not a valid move.');
+        }
+    }
+
+    if (this.currentState.gameOver && !this.currentState.tie) {
+        this.currentState.winningCoords = this.winningCoords();
+    }
 
-    ai = Math.max(0, Math.min((ai !== undefined ? ai : this._ai), 20));
+    return { positionKey: this.positionKey(), currentState: this.currentState };
+};
 
-    /* It has been proven that the best first move for a standard 7x6 game  */
-    /* of connect-4 is the center column.  See Victor Allis' masters thesis */
-    /* ("ftp://ftp.cs.vu.nl/pub/victor/connect4.ps") for this proof.        */
+/**
+ * Gets the entries this game stored in its main transposition table, the most recent first (see
+ * Connect4Table#entries), for a snapshot of the game.
+ *
+ * @param {number} [count] The most entries to return, all of them by default.
+ *
+ * @returns {array} The entries, none without a table.
+ */
+Connect4Game.prototype.exportTable = function(count) {
+    return this._deepTable ? this._deepTable.entries(this._session, count) : [];
+};
 
-    if (this.currentState.numberOfPieces < 2 && this._cols === 7 && this._rows === 6 && this._connect === 4 &&
-            (this.currentState.numberOfPieces === 0 || this.currentState.board[3][0] !== 2)) {
-        return this.makeMove(player, 3);
+/**
+ * Stores entries from exportTable in the main transposition table, as this game's own.
+ *
+ * @param {array} entries The entries.
+ */
+Connect4Game.prototype.importTable = function(entries) {
+    if (this._deepTable) {
+        this._deepTable.load(entries, this._session);
     }
+};
 
-    // Simulate a drop in each of the columns and see what the results are
-
-    for (var i=0; i<this._cols; i++) {
-        this._pushState();
+/**
+ * Makes the best possible move for the given player assuming the other player makes the best possible moves.
+ *
+ * @param {number} player The player, 0 for player 1 and 1 for player 1.
+ * @param {number|string|object} ai The level of the AI, or how deep to search the game tree, from 2, which only
+ *                                  looks at the move itself, to 20; lower levels search level 2. Instead of a
+ *                                  level this can be a difficulty: the name of one of Connect4Game.difficulties
+ *                                  or a budget of the same form. The search then goes one level deeper at a time
+ *                                  for as long as the budget lasts, so the time a move takes hardly depends on
+ *                                  the position.
+ *
+ * With the seed setting the move depends only on the position, the level and the seed, so the same position
+ * always gets the same move no matter what was searched before.
+ *
+ * @returns {object} The same object as makeMove with the level that was searched added as level, which for a
+ *                   difficulty is the deepest level searched to the end. When the trace
+ *                   setting is on the searched tree is added as trace: an object with the names of the fields of
+ *                   each node (see Connect4Game.traceFields) as fields and the nodes in the order they were
+ *                   entered as nodes. Each node is an array of its key, the index of its parent, the column
+ *                   leading to it, its depth, the alpha and beta it was searched with, the columns tried, the
+ *                   index in those of the one that caused a cutoff (or -1), its score and the number of nodes in
+ *                   its subtree. With a difficulty every level searched is in the trace. truncated is true
+ *                   when the quota setting cut the search short, in which case the move is the best found by
+ *                   then.
+ */
+Connect4Game.prototype.autoMove = function(player, ai) {
+    var move = this._startMove(player, ai);
+    this._stepMove(move, Infinity);
+    return this._finishMove(move);
+};
 
-        var column = this._dropOrder[i];
+/**
+ * Plays the given moves from the start of the game, searches for the best move as autoMove does and puts the
+ * game back the way it was, without making the move. This is how the workers of the shared pool search on behalf
+ * of a game whose state they do not keep.
+ *
+ * @param {array} moves The moves to play first as [player, column] pairs.
+ * @param {number} player The player, 0 for player 1 and 1 for player 1.
+ * @param {number|string|object} [ai = settings.ai] The level of the AI or the difficulty, as with autoMove.
+ * @param {number} [reduce = 0] How many levels less to search, though never less than two. For a difficulty the
+ *                              budget shrinks by Connect4Game.levelCost for every level instead.
+ * @param {object} [clock] The clock of the player, as the clock of a budget (see Connect4Game.difficulties).
+ *
+ * @returns {object} An object with the column to play as column, and the level, trace and truncated as with
+ *                   autoMove.
+ */
+Connect4Game.prototype.searchMove = function(moves, player, ai, reduce, clock) {
+    this.startSearch(moves, player, ai, reduce, clock);
+    return this.continueSearch();
+};
 
-        var row = this._dropPiece(player, column);
-        // if this column is full, ignore it as a possiblity
-        if (row < 0) {
-            this._popState();
-            continue;
-        }
-        // if this drop wins the game, take it
-        else if (this.currentState.winner === player) {
-            bestColumn = column;
+/**
+ * Starts the search of searchMove, to be carried out a slice at a time by continueSearch. As with startSolve the
+ * search keeps its own stack rather than recursing, so it can stop after any number of positions and pick up
+ * again later, and whoever drives it can do other work in between. Until it is done or stopped the game is left
+ * in the middle of the search and nothing else may be done with it.
+ *
+ * @param {array} moves The moves to play first as [player, column] pairs.
+ * @param {number} player The player, 0 for player 1 and 1 for player 1.
+ * @param {number|string|object} [ai = settings.ai] The level of the AI or the difficulty, as with searchMove.
+ * @param {number} [reduce = 0] How many levels less to search, as with searchMove.
+ * @param {object} [clock] The clock of the player, as with searchMove.
+ *
+ * @throws An error if a search is already in progress or one of the moves is not valid.
+ */
+Connect4Game.prototype.startSearch = function(moves, player, ai, reduce, clock) {
+    if (this._moveSearch) {
+        throw new Error('There is already a search in progress.');
+    }
 
-            this._debug({
-                action: 'autoMove',
-                checkColumn: column,
-                reason: 'wins',
-                bestColumn: bestColumn
-            });
+    var stack  = this._stateStack,
+        budget = this._budgetOf(ai = ai != null ? ai : this._ai);
 
-            this._popState();
-            break;
-        }
-        // Otherwise, look ahead to see how good this move may turn out
-        // assuming the opponent makes the best moves possible
-        else {
-            goodness = this._evaluate(player, ai, -(Number.MAX_VALUE), -(bestWorst));
+    if (!budget) {
+        // level 2 only looks at the move itself, anything less would never reach the level it stops at
+        ai = Math.max(Math.min(ai, 2), ai - (reduce || 0));
+    }
+    else if (reduce || clock) {
+        ai = this._clone(budget);
+        if (reduce) {
+            var scale = Math.pow(Connect4Game.levelCost, reduce);
+            ai.nodes = budget.nodes && Math.ceil(budget.nodes / scale);
+            ai.time = budget.time && Math.ceil(budget.time / scale);
         }
+    }
 
-        // if this move looks better than the ones previously considered, remember it
-        if (goodness > bestWorst) {
-            bestWorst = goodness;
-            bestColumn = column;
+    // with a clock it is the clock that decides how long to search, a level only decides how deep
+    if (clock) {
+        ai = budget ? ai : { level: ai };
+        ai.clock = clock;
+    }
 
-            this._debug({
-                action: 'autoMove',
-                checkColumn: column,
-                reason: 'better',
-                bestColumn: bestColumn,
-                goodness: goodness,
-                bestWorst: bestWorst
-            });
-        }
-        // if two moves are equally as good, make a random decision
-        else if (goodness === bestWorst) {
-            // BUG: sometimes the only column left to go in is still the worst
-            // and in this case will pick a random column between -1 and the given column...
-            // should find a better fix for this than just the check for -1 value for bestColumn
-            if (bestColumn === -1 || Math.floor(Math.random()*2) > 0) {
-                var prevBestColumn = bestColumn;
-                bestColumn = column;
-
-                this._debug({
-                    action: 'autoMove',
-                    checkColumn: column,
-                    reason: 'random',
-                    bestColumn: bestColumn,
-                    prevBestColumn: prevBestColumn,
-                    goodness: goodness,
-                    bestWorst: bestWorst
-                });
-            }
-        }
+    // the levels of the search count from the bottom of the state stack, so the moves are played into a single
+    // state of their own, which also takes the move autoMove makes
+    this._stateStack = [this._clone(stack[0])];
+    this.currentState = this._stateStack[0];
 
-        this._popState();
+    for (var i=0; i<moves.length; i++) {
+        if (this._dropPiece(moves[i][0], moves[i][1]) < 0) {
+            this._stateStack = stack;
+            this.currentState = stack[stack.length - 1];
+            throw new Error('Not a valid move.');
+        }
     }
 
-    // make the move
-    return this.makeMove(player, bestColumn);
+    this._moveSearch = { stack: stack, nodes: this._metrics.nodes, move: this._startMove(player, ai) };
 };
 
 /**
- * Gets the coordinates of the winning pieces.
+ * Carries on with the search started by startSearch.
  *
- * @returns {Array} The winning coordinates
+ * @param {number} [nodes] How many more positions to search at most before returning, by default as many as it
+ *                         takes to finish.
+ *
+ * @returns {object} An object with the following properties:
+ *                   done: whether the search is finished,
+ *                   nodes: the number of positions searched so far,
+ *                   column, level, trace and truncated: once it is done, as with searchMove.
  */
-Connect4Game.prototype.winningCoords = function() {
-    var winPos = 0,
-        coords = [];
-
-    while (this.currentState.stats[this.currentState.winner][winPos] !== this._magicWinningNumber) {
-        winPos++;
+Connect4Game.prototype.continueSearch = function(nodes) {
+    var search = this._moveSearch;
+    if (!search) {
+        throw new Error('There is no search in progress.');
     }
 
-    for (var column=0; column<this._cols; column++) {
-        for (var row=0; row<this._rows; row++) {
-            var map1, map2;
-            if ((map1 = this.currentState.map[column]) !== undefined && (map2 = map1[row]) !== undefined) {
-                for (var i=0, l=map2.length; i<l; i++) {
-                    if (map2[i] === winPos) {
-                        coords.push([column,row]);
-                    }
-                }
-            }
-        }
+    if (!this._stepMove(search.move, this._metrics.nodes + (nodes || Infinity))) {
+        return { done: false, nodes: this._metrics.nodes - search.nodes };
     }
 
-    return coords;
+    var ret = this._finishMove(search.move);
+    this._stateStack = search.stack;
+    this.currentState = search.stack[search.stack.length - 1];
+    this._moveSearch = null;
+
+    return { done: true, nodes: this._metrics.nodes - search.nodes, column: ret.col, level: ret.level,
+             trace: ret.trace, truncated: ret.truncated };
 };
 
 /**
- * This function drops a piece of the specified player into the specified column. The row where the piece ended
- * up is returned, or -1 if the drop was unsuccessful (i.e., the specified column is full).
- * @private
+ * Abandons the search in progress, if any, and puts the game back the way it was before startSearch.
  *
- * @returns {number} The row where the piece ended up or -1 if the drop was unsuccessful.
+ * @returns {object} An object with the following properties:
+ *                   stopped: whether there was a search to stop,
+ *                   nodes: the number of positions it had searched.
  */
-Connect4Game.prototype._dropPiece = function(player, column) {
-    var row = 0,
-        col = this.currentState.board[column];
+Connect4Game.prototype.stopSearch = function() {
+    var search = this._moveSearch;
+    if (!search) {
+        return { stopped: false, nodes: 0 };
+    }
 
-    while (col[row] !== this._none && (++row < this._rows));
+    this._stateStack = search.stack;
+    this.currentState = search.stack[search.stack.length - 1];
+    this._moveSearch = null;
+    this._budget = null;
+    this._tracer = null;
+    return { stopped: true, nodes: this._metrics.nodes - search.nodes };
+};
 
-    if (row === this._rows) {
-        return -1;
+/**
+ * Gets the counters kept by the game since it was created: searches (the number of moves made by autoMove),
+ * solves (the number of solves) and nodes (the number of positions searched by either). With a tablebase the
+ * hits and misses of its block cache are included as tablebaseHits and tablebaseMisses. With transposition
+ * tables their statistics (see Connect4Table#stats) are included as tables, by tier: shallow and deep. Tables
+ * shared with other games (see the shareTables setting) count what every game sharing them did, and come with
+ * what they are shared by as tableShare, so that they can be counted once.
+ *
+ * @returns {object} The counters.
+ */
+Connect4Game.prototype.metrics = function() {
+    this._metrics.tableShare = this._tableShare;
+    if (this._deepTable) {
+        this._metrics.tables = { deep: this._deepTable.stats() };
+        if (this._shallowTable !== this._deepTable) {
+            this._metrics.tables.shallow = this._shallowTable.stats();
+        }
     }
+    if (this._tablebaseReader) {
+        this._metrics.tablebaseHits = this._tablebaseReader.hits;
+        this._metrics.tablebaseMisses = this._tablebaseReader.misses;
+    }
+    return this._metrics;
+};
 
-    this.currentState.board[column][row] = player;
-    this.currentState.numberOfPieces++;
-    this._updateScore(player, column, row);
+/**
+ * Gets a random number between 0 and 1. Without a seed this is Math.random, with one it is a minimal standard
+ * (Park-Miller) generator seeded by autoMove.
+ * @private
+ */
+Connect4Game.prototype._random = function() {
+    if (this._seed === null) {
+        return Math.random();
+    }
+    this._randomState = this._randomState * 16807 % 2147483647;
+    return (this._randomState - 1) / 2147483646;
+};
 
-    return row;
+/**
+ * Gets the index of the current position in a tablebase (see Connect4Tablebase.index), for building one from
+ * the results of solve.
+ *
+ * @returns {number} The index.
+ */
+Connect4Game.prototype.tablebaseIndex = function() {
+    return Connect4Tablebase.index(this.currentState.board, this._cols, this._rows);
 };
 
 /**
- * This function updates the score of the specified player in the context of the current state, given that the
- * player has just placed a game piece in column x, row y.
+ * Sets up the search of autoMove, for _stepMove to carry out and _finishMove to turn into the move. Moves that
+ * need no search, the first ones of the standard board and the ones in the opening book, are settled right away.
  * @private
  *
- * @param {number} player The player, 0 for player 1 and 1 for player 1.
- * @param {number} column The column starting at 0.
- * @param {number} row The row starting at 0.
+ * @returns {object} The move being searched.
  */
-Connect4Game.prototype._updateScore = function(player, column, row) {
-    var thisDiff    = 0,
-        otherDiff   = 0,
-        otherPlayer = this._other(player),
-        map         = this.currentState.map[column][row],
-        stats       = this.currentState.stats,
-        length      = map.length;
+Connect4Game.prototype._startMove = function(player, ai) {
+    var budget = this._budgetOf(ai != null ? ai : this._ai),
+        move;
 
-    for (var i=0; i < length; i++) {
-        var winIndex = map[i];
-        thisDiff  += stats[player][winIndex];
-        otherDiff += stats[otherPlayer][winIndex];
+    // level 2 only looks at the move itself, which is as little as a search can do
+    ai = budget ? null : Math.max(2, Math.min((ai != null ? ai : this._ai), 20));
 
-        stats[player][winIndex] <<= 1;
-        stats[otherPlayer][winIndex] = 0;
+    // under a quota every search deepens as far as the quota lets it, so that there is a move to fall back on
+    if (this._quota && (this._quota.nodes || this._quota.time)) {
+        budget = budget ? this._clone(budget) : { level: ai };
+        budget.quota = this._quota;
+    }
 
-        if (stats[player][winIndex] == this._magicWinningNumber) {
-            if (this.currentState.winner == this._none) {
-                this.currentState.winner = player;
-            }
-        }
+    this._tracer = this._trace ? { nodes: [], parent: -1 } : null;
+    this._ageTables();
+
+    // with a seed the random choices depend on nothing but the seed and the position
+    if (this._seed !== null) {
+        this._randomState = Connect4Table.hash(this._seed + '|' + this.positionKey()) % 2147483646 + 1;
     }
 
-    this.currentState.score[player] += thisDiff;
-    this.currentState.score[otherPlayer] -= otherDiff;
+    move = { player: player, ai: ai, budget: budget, column: -1, level: undefined, truncated: false, root: null,
+             stack: [], value: 0, loop: null };
 
-    if (this.currentState.winner > -1 || this.isTie()) {
-        this.currentState.gameOver = true;
-        this.currentState.tie = this.isTie();
+    /* It has been proven that the best first move for a standard 7x6 game  */
+    /* of connect-4 is the center column.  See Victor Allis' masters thesis */
+    /* ("ftp://ftp.cs.vu.nl/pub/victor/connect4.ps") for this proof.        */
+
+    if (this.currentState.numberOfPieces < 2 && this._cols === 7 && this._rows === 6 && this._connect === 4 &&
+            (this.currentState.numberOfPieces === 0 || this.currentState.board[3][0] !== 2)) {
+        move.column = 3;
+        return move;
     }
+
+    // If the opening book knows this position there is no need to search
+
+    var bookColumn = this._bookMove();
+    if (bookColumn >= 0) {
+        this._debug({
+            action: 'autoMove',
+            checkColumn: bookColumn,
+            reason: 'book',
+            bestColumn: bookColumn
+        });
+
+        move.column = bookColumn;
+        return move;
+    }
+
+    if (!budget) {
+        move.root = this._rootStart(player, ai, 0);
+    }
+    else {
+        this._budgetStart(move);
+    }
+    return move;
 };
 
 /**
- * This recursive function determines how good the current state may turn out to be for the specified player.
- * It does this by looking ahead level moves. It is assumed that both the specified player and the opponent
- * may make the best move possible. alpha and beta are used for alpha-beta cutoff so that the game tree can be
- * pruned to avoid searching unneccessary paths.
+ * Searches the move set up by _startMove until it is found or the metrics count the given number of nodes.
+ * @private
  *
- * The worst goodness that the current state can produce in the number of moves (levels) searched is returned.
- * This is the best the specified player can hope to achieve with this state (since it is assumed that the
- * opponent will make the best moves possible).
+ * @returns {boolean} Whether the move has been found.
+ */
+Connect4Game.prototype._stepMove = function(move, limit) {
+    while (move.root && this._metrics.nodes < limit) {
+        if (!this._rootSteps(move, limit)) {
+            break;
+        }
+        if (move.loop) {
+            this._budgetNext(move);
+        }
+        else {
+            move.column = move.root.column;
+            move.root = null;
+        }
+    }
+    return !move.root;
+};
+
+/**
+ * Makes the move found by _stepMove and returns what autoMove does.
  * @private
  */
-Connect4Game.prototype._evaluate = function(player, level, alpha, beta) {
-    var goodness, best, maxab, depth = this._stateStack.length;
+Connect4Game.prototype._finishMove = function(move) {
+    var ret = this.makeMove(move.player, move.column);
+
+    ret.level = move.level !== undefined ? move.level : move.ai;
+    ret.truncated = !!move.truncated;
+    this._metrics.searches++;
 
-    if (level === depth) {
-        return this._goodnessOf(player);
+    if (this._tracer) {
+        ret.trace = { fields: Connect4Game.traceFields, nodes: this._tracer.nodes };
+        this._tracer = null;
     }
-    else {
-        /* Assume it is the other player's turn. */
-        best = -(Number.MAX_VALUE);
-        maxab = alpha;
 
-        for (var i=0; i<this._cols; i++) {
-            this._pushState();
+    return ret;
+};
 
-            if (this._dropPiece(this._other(player), this._dropOrder[i]) < 0) {
-                this._popState();
-                continue;
-            }
-            else if (this.currentState.winner === this._other(player)) {
-                goodness = Number.MAX_VALUE - depth;
-            }
-            else {
-                goodness = this._evaluate(this._other(player), level, -beta, -maxab);
-            }
+/**
+ * Starts the search of a move with a budget: ever deeper, starting at level 2, until the next level would go
+ * over the budget. Only levels that were searched to the end count, so the move is the one found by the deepest
+ * of those. The budget is checked as the search goes (see _checkBudget) and a level that runs out of it is
+ * abandoned. Level 2 is always searched to the end, so there is always a move, even when the budget has a level
+ * below it: levels 0 and 1 stand for the weakest search there is, so they search level 2 alone.
+ *
+ * A quota is a budget that the search is not meant to run out of. When it does anyway, the result is marked as
+ * truncated.
+ *
+ * With a clock the time for the move comes from the clock (see _clockLimits). No level is started after the soft
+ * limit has passed or when it could not finish before the hard limit, and the search stops early once one move
+ * is better than every other by the dominance margin of Connect4Game.clock and has stayed the best for a few
+ * levels. Each time the best move changes from one level to the next the soft limit is pushed back, since the
+ * search has not settled yet.
+ * @private
+ */
+Connect4Game.prototype._budgetStart = function(move) {
+    var budget  = move.budget,
+        empty   = this._cols * this._rows - this.currentState.numberOfPieces,
+        depth   = this._stateStack.length,
+        started = new Date().getTime(),
+        limits  = budget.clock ? this._clockLimits(budget.clock, empty) : null,
+        margin  = budget.margin || 0,
+        quota   = budget.quota || {};
+
+    this._budget = {
+        nodes: budget.nodes ? this._metrics.nodes + budget.nodes : Infinity,
+        time: Math.min(budget.time ? started + budget.time : Infinity, limits ? started + limits.hard : Infinity),
+        quota: {
+            nodes: quota.nodes ? this._metrics.nodes + quota.nodes : Infinity,
+            time: quota.time ? started + quota.time : Infinity
+        },
+        armed: false,
+        exceeded: false,
+        truncated: false
+    };
+    this._budget.nodes = Math.min(this._budget.nodes, this._budget.quota.nodes);
+    this._budget.time = Math.min(this._budget.time, this._budget.quota.time);
+
+    move.loop = {
+        empty: empty,
+        depth: depth,
+        started: started,
+        begun: started,
+        limits: limits,
+        margin: margin,
+        window: limits ? Math.max(margin, Connect4Game.clock.dominance) : margin,
+        level: depth + 1,
+        last: budget.level != null ? Math.max(depth + 1, Math.min(budget.level, 20)) : 20,
+        stable: 0,
+        found: null
+    };
 
-            if (goodness > best) {
-                best = goodness;
-                if (best > maxab) {
-                    maxab = best;
-                }
-            }
+    move.root = this._rootStart(move.player, move.loop.level, move.loop.window);
+};
 
-            this._popState();
-            if (best > beta) {
-                break;
-            }
-        }
+/**
+ * Takes the result of a level searched with a budget and starts the next level, if there is to be one.
+ * @private
+ */
+Connect4Game.prototype._budgetNext = function(move) {
+    var loop   = move.loop,
+        result = move.root,
+        policy = Connect4Game.clock,
+        limits = loop.limits,
+        now    = new Date().getTime();
+
+    move.root = null;
+    if (this._budget.exceeded) {
+        loop.found.truncated = this._budget.truncated;
+        return this._budgetEnd(move);
+    }
 
-        // What's good for the other player is bad for this one
-        return -best;
+    if (loop.found && result.column !== loop.found.column) {
+        loop.stable = 0;
+        limits && (limits.soft = Math.min(limits.hard, limits.soft * policy.instability));
+    }
+    else if (loop.found) {
+        loop.stable++;
+    }
+
+    loop.found = result;
+    result.level = loop.level;
+    // a forced win or loss stays one however deep the search goes, and so does a search to the end of the game
+    if (result.wins || Math.abs(result.goodness) === Number.MAX_VALUE || loop.level - loop.depth >= loop.empty) {
+        return this._budgetEnd(move);
+    }
+    if (limits && (now - loop.started >= limits.soft ||
+            (loop.stable >= policy.stable && this._nearMoves(result, policy.dominance).length === 1) ||
+            now - loop.started + (now - loop.begun) * Connect4Game.levelCost > limits.hard)) {
+        return this._budgetEnd(move);
+    }
+    this._budget.armed = true;
+
+    if (++loop.level > loop.last) {
+        return this._budgetEnd(move);
+    }
+    loop.begun = new Date().getTime();
+    move.root = this._rootStart(move.player, loop.level, loop.window);
+};
+
+/**
+ * Settles the move of a search with a budget on the deepest level searched to the end.
+ * @private
+ */
+Connect4Game.prototype._budgetEnd = function(move) {
+    var found = move.loop.found, margin = move.loop.margin;
+
+    this._budget = null;
+
+    var near = margin > 0 && !found.wins ? this._nearMoves(found, margin) : [];
+    if (near.length > 1) {
+        found.column = near[Math.floor(this._random() * near.length)];
+
+        this._debug({
+            action: 'autoMove',
+            reason: 'near',
+            bestColumn: found.column,
+            near: near,
+            bestWorst: found.goodness
+        });
+    }
+
+    move.column = found.column;
+    move.level = found.level;
+    move.truncated = found.truncated;
+};
+
+/**
+ * Works out how long a move may take from a Fischer clock. The soft limit is the player's share of the time left,
+ * assuming the game takes every empty space, plus most of the increment. The hard limit is a few soft limits but
+ * never more than a share of the time left, and it always leaves the reserve on the clock.
+ * @private
+ *
+ * @returns {object} The soft and hard limits in milliseconds.
+ */
+Connect4Game.prototype._clockLimits = function(clock, empty) {
+    var policy = Connect4Game.clock,
+        left   = Math.max(0, clock.remaining - policy.reserve),
+        moves  = Math.max(1, Math.ceil(empty / 2)),
+        soft   = left / moves + (clock.increment || 0) * policy.increment,
+        hard   = Math.min(soft * policy.hard, left * policy.share + (clock.increment || 0), left);
+
+    return { soft: Math.min(soft, hard), hard: hard };
+};
+
+/**
+ * Gets the columns whose goodness is within the given margin of the best, which needs _rootSteps to have
+ * searched with at least that margin.
+ * @private
+ */
+Connect4Game.prototype._nearMoves = function(found, margin) {
+    var near = [];
+    for (var i=0; i<found.scores.length; i++) {
+        if (found.scores[i][1] >= found.goodness - margin) {
+            near.push(found.scores[i][0]);
+        }
+    }
+    return near.length ? near : [found.column];
+};
+
+/**
+ * Checks whether the search with a budget has gone over it, after which the search unwinds without looking any
+ * further (see _evaluateEnter). The clock is only read every 64 nodes.
+ * @private
+ */
+Connect4Game.prototype._checkBudget = function() {
+    var budget = this._budget, nodes = this._metrics.nodes, now;
+
+    if (budget.armed && (nodes > budget.nodes ||
+            (budget.time !== Infinity && (nodes & 63) === 0 && (now = new Date().getTime()) > budget.time))) {
+        budget.exceeded = true;
+        budget.truncated = nodes > budget.quota.nodes || now > budget.quota.time;
+    }
+    return budget.exceeded;
+};
+
+/**
+ * Gets the budget for a difficulty: the preset of that name, or the difficulty itself if it is already a budget.
+ * A level has no budget.
+ * @private
+ *
+ * @throws An error if there is no preset of that name.
+ */
+Connect4Game.prototype._budgetOf = function(ai) {
+    if (typeof ai === 'string') {
+        if (!Connect4Game.difficulties.hasOwnProperty(ai)) {
+            throw new Error('Not a valid difficulty.');
+        }
+        return Connect4Game.difficulties[ai];
+    }
+    return ai !== null && typeof ai === 'object' ? ai : null;
+};
+
+/**
+ * Starts searching every column at the given level to pick the best, see _rootSteps. With a margin the columns
+ * within the margin of the best are searched exactly rather than just proven worse, see _nearMoves.
+ * @private
+ *
+ * @returns {object} The search of the columns, which ends up with the column as column, its goodness as
+ *                   goodness, whether it wins right away as wins and the goodness found for every column searched
+ *                   as scores, in [column, goodness] pairs.
+ */
+Connect4Game.prototype._rootStart = function(player, level, margin) {
+    return {
+        player: player,
+        level: level,
+        margin: margin,
+        next: 0,
+        checking: -1,
+        waiting: false,
+        column: -1,
+        goodness: -(Number.MAX_VALUE),
+        wins: false,
+        scores: []
+    };
+};
+
+/**
+ * Searches the columns of move.root until they are all searched or the metrics count the given number of nodes.
+ * Each column is searched by the stack of _evaluateSteps, in move.stack.
+ * @private
+ *
+ * @returns {boolean} Whether every column has been searched.
+ */
+Connect4Game.prototype._rootSteps = function(move, limit) {
+    var root = move.root, goodness;
+
+    for (;;) {
+        if (root.waiting) {
+            this._evaluateSteps(move, limit);
+            if (move.stack.length > 0) {
+                return false;
+            }
+            root.waiting = false;
+            this._rootScore(root, move.value);
+        }
+        if (root.next >= this._cols) {
+            return true;
+        }
+        if (this._metrics.nodes >= limit) {
+            return false;
+        }
+
+        // Simulate a drop in the next column and see what the result is
+
+        this._pushState();
+
+        var column = this._dropOrder[root.next++];
+
+        // if this column is full, ignore it as a possiblity
+        if (this._dropPiece(root.player, column) < 0) {
+            this._popState();
+        }
+        // if this drop wins the game, take it
+        else if (this.currentState.winner === root.player) {
+            root.column = column;
+            root.wins = true;
+            root.next = this._cols;
+
+            this._debug({
+                action: 'autoMove',
+                checkColumn: column,
+                reason: 'wins',
+                bestColumn: column
+            });
+
+            this._popState();
+        }
+        // Otherwise, look ahead to see how good this move may turn out
+        // assuming the opponent makes the best moves possible
+        else {
+            if (this._tracer) {
+                this._tracer.column = column;
+            }
+            root.checking = column;
+            goodness = this._evaluateEnter(move.stack, root.player, root.level, -(Number.MAX_VALUE),
+                -(root.goodness - root.margin));
+            if (goodness !== null) {
+                this._rootScore(root, goodness);
+            }
+            else {
+                root.waiting = true;
+            }
+        }
+    }
+};
+
+/**
+ * Takes the goodness found for the column being searched by _rootSteps.
+ * @private
+ */
+Connect4Game.prototype._rootScore = function(root, goodness) {
+    var column = root.checking;
+
+    root.scores.push([column, goodness]);
+
+    // if this move looks better than the ones previously considered, remember it
+    if (goodness > root.goodness) {
+        root.goodness = goodness;
+        root.column = column;
+
+        this._debug({
+            action: 'autoMove',
+            checkColumn: column,
+            reason: 'better',
+            bestColumn: column,
+            goodness: goodness,
+            bestWorst: goodness
+        });
+    }
+    // if two moves are equally as good, make a random decision
+    else if (goodness === root.goodness) {
+        // BUG: sometimes the only column left to go in is still the worst
+        // and in this case will pick a random column between -1 and the given column...
+        // should find a better fix for this than just the check for -1 value for bestColumn
+        if (root.column === -1 || Math.floor(this._random()*2) > 0) {
+            var prevBestColumn = root.column;
+            root.column = column;
+
+            this._debug({
+                action: 'autoMove',
+                checkColumn: column,
+                reason: 'random',
+                bestColumn: column,
+                prevBestColumn: prevBestColumn,
+                goodness: goodness,
+                bestWorst: root.goodness
+            });
+        }
+    }
+
+    this._popState();
+};
+
+/**
+ * Solves the current position exactly for the player to move. The score is positive if the player to move can
+ * force a win, negative if the opponent can and 0 for a draw. The sooner a win can be forced the larger the
+ * score: a win made with the move that leaves n empty spaces scores n + 1.
+ *
+ * @param {number} player The player to move, 0 for player 1 and 1 for player 2.
+ * @param {number} [alpha] The lower bound of the search window, defaults to the lowest possible score.
+ * @param {number} [beta] The upper bound of the search window, defaults to the highest possible score.
+ *
+ * @returns {object} An object with the following properties:
+ *                   score: the score of the position, which is only a bound if it falls outside the window,
+ *                   nodes: the number of positions searched,
+ *                   truncated: true if the quota setting stopped the solve, in which case score is null.
+ */
+Connect4Game.prototype.solve = function(player, alpha, beta) {
+    this.startSolve(player, alpha, beta);
+    return this.continueSolve();
+};
+
+/**
+ * Plays the given moves, solves the resulting position and takes the moves back again. This is the unit of
+ * work handed to helper workers when a solve is split between several of them.
+ *
+ * @param {array} moves The moves to play as [player, column] pairs.
+ * @param {number} player The player to move once the moves have been played.
+ * @param {number} [alpha] The lower bound of the search window.
+ * @param {number} [beta] The upper bound of the search window.
+ * @param {object} [quota = settings.quota] The quota for this solve, see startSolve.
+ *
+ * @returns {object} The result of solve.
+ */
+Connect4Game.prototype.solvePosition = function(moves, player, alpha, beta, quota) {
+    this.startSolve(player, alpha, beta, moves, quota);
+    return this.continueSolve();
+};
+
+/**
+ * Starts a solve that is carried out a slice at a time by continueSolve. The search keeps its own stack rather
+ * than recursing, so it can stop after any number of positions and pick up again later, and whoever drives it
+ * can do other work in between. Until it is done or stopped the game is left in the middle of the search and
+ * nothing else may be done with it.
+ *
+ * @param {number} player The player to move, 0 for player 1 and 1 for player 2.
+ * @param {number} [alpha] The lower bound of the search window, defaults to the lowest possible score.
+ * @param {number} [beta] The upper bound of the search window, defaults to the highest possible score.
+ * @param {array} [moves] Moves to play first as [player, column] pairs, they are taken back once the solve is
+ *                        done or stopped.
+ * @param {object} [quota = settings.quota] The most positions (nodes) and milliseconds (time) the solve may take.
+ *                                          A solve that goes over either is stopped, see continueSolve.
+ *
+ * @throws An error if a solve is already in progress or one of the moves is not valid.
+ */
+Connect4Game.prototype.startSolve = function(player, alpha, beta, moves, quota) {
+    if (this._search) {
+        throw new Error('There is already a solve in progress.');
+    }
+
+    var limit   = this._cols * this._rows + 1,
+        restore = this._playMoves(moves || []),
+        search  = this._search = { stack: [], restore: restore, nodes: 0, value: null, limit: null };
+
+    this._ageTables();
+
+    quota = quota || this._quota;
+    if (quota && (quota.nodes || quota.time)) {
+        search.limit = {
+            nodes: quota.nodes || Infinity,
+            time: quota.time ? new Date().getTime() + quota.time : Infinity
+        };
+    }
+
+    this._nodes = 0;
+    search.value = this._solveEnter(search.stack, player, alpha != null ? alpha : -limit,
+        beta != null ? beta : limit);
+    this._metrics.nodes += this._nodes;
+    search.nodes = this._nodes;
+};
+
+/**
+ * Carries on with the solve started by startSolve.
+ *
+ * @param {number} [nodes] How many more positions to search at most before returning, by default as many as it
+ *                         takes to finish.
+ *
+ * With a limit the positions are counted and the clock is read every 64 positions as the search goes, and a solve
+ * that goes over its limit is stopped as with stopSolve. It then counts as done, with a null score and truncated
+ * set.
+ *
+ * @returns {object} An object with the following properties:
+ *                   done: whether the solve is finished,
+ *                   score: the score as with solve, once it is done,
+ *                   nodes: the number of positions searched so far,
+ *                   truncated: whether the limit stopped the solve.
+ */
+Connect4Game.prototype.continueSolve = function(nodes) {
+    var search = this._search;
+    if (!search) {
+        throw new Error('There is no solve in progress.');
+    }
+
+    var limit  = search.limit,
+        target = Math.min(search.nodes + (nodes || Infinity), limit ? limit.nodes : Infinity),
+        over   = false;
+
+    this._nodes = search.nodes;
+    while (search.stack.length > 0 && this._nodes < target && !over) {
+        this._solveSteps(search, limit ? Math.min(target - this._nodes, 64) : target - this._nodes);
+        over = limit !== null && (this._nodes >= limit.nodes || new Date().getTime() > limit.time);
+    }
+    this._metrics.nodes += this._nodes - search.nodes;
+    search.nodes = this._nodes;
+
+    if (search.stack.length > 0 && over) {
+        this.stopSolve();
+        return { done: true, score: null, nodes: search.nodes, truncated: true };
+    }
+    else if (search.stack.length > 0) {
+        return { done: false, score: null, nodes: search.nodes, truncated: false };
+    }
+
+    this._takeBack(search.restore);
+    this._search = null;
+    this._metrics.solves++;
+
+    return { done: true, score: search.value, nodes: search.nodes, truncated: false };
+};
+
+/**
+ * Abandons the solve in progress, if any, and puts the game back the way it was before startSolve.
+ *
+ * @returns {object} An object with the following properties:
+ *                   stopped: whether there was a solve to stop,
+ *                   nodes: the number of positions it had searched.
+ */
+Connect4Game.prototype.stopSolve = function() {
+    var search = this._search;
+    if (!search) {
+        return { stopped: false, nodes: 0 };
+    }
+
+    this._takeBack(search.restore);
+    this._search = null;
+    return { stopped: true, nodes: search.nodes };
+};
+
+/**
+ * Lists every line of play the given number of moves deep from the current position, starting with the given
+ * player. Lines that end the game early are cut short and come with their score already known; the rest have to
+ * be solved. The lines are listed in the order the search would try them.
+ *
+ * @param {number} player The player to move.
+ * @param {number} depth How many moves deep the frontier lies.
+ * @param {array} [moves] Moves to play first as [player, column] pairs, they are taken back afterwards.
+ *
+ * @returns {array} A list of objects with the following properties:
+ *                  path: the columns played, alternating between the players,
+ *                  score: the score for the player to move at the end of the path, if the game is over there.
+ */
+Connect4Game.prototype.frontier = function(player, depth, moves) {
+    var frontier = [],
+        restore  = this._playMoves(moves || []);
+
+    this._expandFrontier(player, depth, [], frontier);
+    this._takeBack(restore);
+    return frontier;
+};
+
+/**
+ * Counts the lines of play the given number of moves deep from the current position (perft), which checks the
+ * move generation and measures it on its own, as nothing is evaluated. A line ends early when the game is over,
+ * so a game-ending position has no moves after it, whatever its depth.
+ *
+ * @param {number} player The player to move.
+ * @param {number} depth How many moves deep to count.
+ * @param {array} [moves] Moves to play first as [player, column] pairs, they are taken back afterwards.
+ * @param {boolean} [unique = false] Whether to also list the positions depth moves deep, each once however many
+ *                                   lines lead to it.
+ *
+ * @returns {object} An object with the following properties:
+ *                   nodes: the number of lines depth moves deep, including the ones whose last move ended the
+ *                          game,
+ *                   terminal: the number of lines that ended the game within depth moves,
+ *                   visited: the number of positions generated along the way, the starting one included,
+ *                   keys: with unique, the keys of the positions depth moves deep, the pieces of each column from
+ *                         the bottom up with the columns separated by |.
+ */
+Connect4Game.prototype.perft = function(player, depth, moves, unique) {
+    this.startPerft(player, depth, moves, unique);
+    var counts = this.continuePerft();
+    delete counts.done;
+    return counts;
+};
+
+/**
+ * Starts the count of perft, to be carried out a slice at a time by continuePerft. As with startSolve the count
+ * keeps its own stack rather than recursing, and until it is done or stopped nothing else may be done with the
+ * game.
+ *
+ * @param {number} player The player to move.
+ * @param {number} depth How many moves deep to count.
+ * @param {array} [moves] Moves to play first as [player, column] pairs, they are taken back once the count is
+ *                        done or stopped.
+ * @param {boolean} [unique = false] Whether to also list the positions depth moves deep, as with perft.
+ *
+ * @throws An error if a count is already in progress or one of the moves is not valid.
+ */
+Connect4Game.prototype.startPerft = function(player, depth, moves, unique) {
+    if (this._perftRun) {
+        throw new Error('There is already a perft in progress.');
+    }
+
+    var restore = this._playMoves(moves || []);
+    this._perftRun = { stack: [], restore: restore, counts: { nodes: 0, terminal: 0, visited: 0 },
+                       keys: unique ? {} : null };
+    this._perftEnter(this._perftRun, player, depth);
+};
+
+/**
+ * Carries on with the count started by startPerft.
+ *
+ * @param {number} [nodes] How many more positions to visit at most before returning, by default as many as it
+ *                         takes to finish.
+ *
+ * @returns {object} The counts so far as with perft, keys only once it is done, and whether it is done as done.
+ */
+Connect4Game.prototype.continuePerft = function(nodes) {
+    var run = this._perftRun;
+    if (!run) {
+        throw new Error('There is no perft in progress.');
+    }
+
+    var counts = run.counts,
+        target = counts.visited + (nodes || Infinity);
+
+    while (run.stack.length > 0 && counts.visited < target) {
+        var frame = run.stack[run.stack.length - 1];
+        if (frame.next === this._cols) {
+            // the state of the first frame is the position the count started from, which is taken back below
+            run.stack.pop();
+            run.stack.length > 0 && this._popState();
+            continue;
+        }
+
+        this._pushState();
+        if (this._dropPiece(frame.player, frame.next++) < 0 ||
+                !this._perftEnter(run, this._other(frame.player), frame.depth - 1)) {
+            this._popState();
+        }
+    }
+
+    if (run.stack.length > 0) {
+        return { done: false, nodes: counts.nodes, terminal: counts.terminal, visited: counts.visited };
+    }
+
+    this._takeBack(run.restore);
+    this._perftRun = null;
+
+    if (run.keys) {
+        counts.keys = [];
+        for (var key in run.keys) {
+            run.keys.hasOwnProperty(key) && counts.keys.push(key);
+        }
+    }
+    counts.done = true;
+    return counts;
+};
+
+/**
+ * Abandons the count in progress, if any, and puts the game back the way it was before startPerft.
+ *
+ * @returns {object} An object with the following properties:
+ *                   stopped: whether there was a count to stop,
+ *                   nodes: the number of positions it had visited.
+ */
+Connect4Game.prototype.stopPerft = function() {
+    var run = this._perftRun;
+    if (!run) {
+        return { stopped: false, nodes: 0 };
+    }
+
+    this._takeBack(run.restore);
+    this._perftRun = null;
+    return { stopped: true, nodes: run.counts.visited };
+};
+
+/**
+ * Indexes games by the positions they passed through, for an archive of games (see Connect4#indexGames). Every
+ * game is replayed from the empty board, whatever the current position, and each position it passed through, up
+ * to depth moves in, is credited with the game, its result and the move it went on with. Positions go by their
+ * canonical key (see positionKey) and the moves by their column in the position of that key, a position that is
+ * its own mirror image taking the lower of the two columns.
+ *
+ * @param {array} games The games as [id, moves] pairs, the moves as [player, column] pairs.
+ * @param {number} [depth] How many moves in to index, every position by default.
+ *
+ * @returns {object} An object with the following properties:
+ *                   games: the number of games indexed,
+ *                   skipped: the ids of the games left out for a move that is not valid or comes after the end,
+ *                   positions: by key, an object with stats: the games, the wins of player 1, the wins of player 2
+ *                              and the draws; ids: the ids of the games; and next: the stats by the column played
+ *                              next.
+ */
+Connect4Game.prototype.indexGames = function(games, depth) {
+    this.startIndex(games, depth);
+    var index = this.continueIndex();
+    delete index.done;
+    return index;
+};
+
+/**
+ * Starts indexing games as indexGames does, to be carried out a slice at a time by continueIndex. The games are
+ * replayed on a board of their own, so the game itself is left as it is.
+ *
+ * @param {array} games The games as [id, moves] pairs, as with indexGames.
+ * @param {number} [depth] How many moves in to index, every position by default.
+ *
+ * @throws An error if an index is already in progress.
+ */
+Connect4Game.prototype.startIndex = function(games, depth) {
+    if (this._indexRun) {
+        throw new Error('There is already an index in progress.');
+    }
+
+    this._indexBoard = this._indexBoard || new Connect4Game({
+        cols: this._cols, rows: this._rows, connect: this._connect, tableSize: 0
+    });
+    this._indexRun = { games: games, depth: depth, next: 0, replayed: 0,
+                       index: { games: 0, skipped: [], positions: {} } };
+};
+
+/**
+ * Carries on with the index started by startIndex.
+ *
+ * @param {number} [nodes] How many more positions to replay at most, as whole games, before returning, by
+ *                         default as many as it takes to finish.
+ *
+ * @returns {object} Whether it is done as done and, once it is, the index as with indexGames.
+ */
+Connect4Game.prototype.continueIndex = function(nodes) {
+    var run = this._indexRun;
+    if (!run) {
+        throw new Error('There is no index in progress.');
+    }
+
+    var target = run.replayed + (nodes || Infinity);
+    while (run.next < run.games.length && run.replayed < target) {
+        this._indexGame(run, run.games[run.next++]);
+    }
+
+    if (run.next < run.games.length) {
+        return { done: false, nodes: run.replayed };
+    }
+
+    this._indexRun = null;
+    run.index.done = true;
+    return run.index;
+};
+
+/**
+ * Abandons the index in progress, if any.
+ *
+ * @returns {object} An object with the following properties:
+ *                   stopped: whether there was an index to stop,
+ *                   nodes: the number of positions it had replayed.
+ */
+Connect4Game.prototype.stopIndex = function() {
+    var run = this._indexRun;
+    this._indexRun = null;
+    return { stopped: !!run, nodes: run ? run.replayed : 0 };
+};
+
+/**
+ * Replays a game of an index and credits the positions it passed through with it, see indexGames.
+ * @private
+ */
+Connect4Game.prototype._indexGame = function(run, game) {
+    var index  = run.index,
+        moves  = game[1],
+        passed = this._indexBoard._indexLine(moves, run.depth),
+        result = 0;
+
+    run.replayed += moves.length + 1;
+    if (!passed) {
+        index.skipped.push(game[0]);
+        return;
+    }
+
+    // the stats count the games, then the wins of each player and the draws, unfinished games only the first
+    if (passed.state.tie) {
+        result = 3;
+    }
+    else if (passed.state.gameOver) {
+        result = passed.state.winner + 1;
+    }
+
+    index.games++;
+    for (var j=0; j<passed.positions.length; j++) {
+        var key = passed.positions[j][0], column = passed.positions[j][1],
+            position = index.positions[key];
+
+        if (!index.positions.hasOwnProperty(key)) {
+            position = index.positions[key] = { stats: [0, 0, 0, 0], ids: [], next: {} };
+        }
+        position.stats[0]++;
+        result && position.stats[result]++;
+        position.ids.push(game[0]);
+        if (column >= 0) {
+            var next = position.next[column] || (position.next[column] = [0, 0, 0, 0]);
+            next[0]++;
+            result && next[result]++;
+        }
+    }
+};
+
+/**
+ * Gets the canonical key of the current position. A position and its mirror image share the same key, so an
+ * opening book only needs to store one of them. Keys are what the book setting is indexed by.
+ *
+ * @returns {string} The canonical position key.
+ */
+Connect4Game.prototype.positionKey = function() {
+    return this._positionKey().key;
+};
+
+/**
+ * Gets the coordinates of the winning pieces.
+ *
+ * @returns {Array} The winning coordinates
+ */
+Connect4Game.prototype.winningCoords = function() {
+    var winPos = 0,
+        coords = [];
+
+    while (this.currentState.stats[this.currentState.winner][winPos] !== this._magicWinningNumber) {
+        winPos++;
+    }
+
+    for (var column=0; column<this._cols; column++) {
+        for (var row=0; row<this._rows; row++) {
+            var map1, map2;
+            if ((map1 = this.currentState.map[column]) !== undefined && (map2 = map1[row]) !== undefined) {
+                for (var i=0, l=map2.length; i<l; i++) {
+                    if (map2[i] === winPos) {
+                        coords.push([column,row]);
+                    }
+                }
+            }
+        }
+    }
+
+    return coords;
+};
+
+/**
+ * This function drops a piece of the specified player into the specified column. The row where the piece ended
+ * up is returned, or -1 if the drop was unsuccessful (i.e., the specified column is full).
+ * @private
+ *
+ * @returns {number} The row where the piece ended up or -1 if the drop was unsuccessful.
+ */
+Connect4Game.prototype._dropPiece = function(player, column) {
+    var row = 0,
+        col = this.currentState.board[column];
+
+    while (col[row] !== this._none && (++row < this._rows));
+
+    if (row === this._rows) {
+        return -1;
+    }
+
+    this.currentState.board[column][row] = player;
+    this.currentState.numberOfPieces++;
+    this._updateScore(player, column, row);
+
+    return row;
+};
+
+/**
+ * This function updates the score of the specified player in the context of the current state, given that the
+ * player has just placed a game piece in column x, row y.
+ * @private
+ *
+ * @param {number} player The player, 0 for player 1 and 1 for player 1.
+ * @param {number} column The column starting at 0.
+ * @param {number} row The row starting at 0.
+ */
+Connect4Game.prototype._updateScore = function(player, column, row) {
+    var thisDiff    = 0,
+        otherDiff   = 0,
+        otherPlayer = this._other(player),
+        map         = this.currentState.map[column][row],
+        stats       = this.currentState.stats,
+        length      = map.length;
+
+    for (var i=0; i < length; i++) {
+        var winIndex = map[i];
+        thisDiff  += stats[player][winIndex];
+        otherDiff += stats[otherPlayer][winIndex];
+
+        stats[player][winIndex] <<= 1;
+        stats[otherPlayer][winIndex] = 0;
+
+        if (stats[player][winIndex] == this._magicWinningNumber) {
+            if (this.currentState.winner == this._none) {
+                this.currentState.winner = player;
+            }
+        }
+    }
+
+    this.currentState.score[player] += thisDiff;
+    this.currentState.score[otherPlayer] -= otherDiff;
+
+    if (this.currentState.winner > -1 || this.isTie()) {
+        this.currentState.gameOver = true;
+        this.currentState.tie = this.isTie();
+    }
+};
+
+/**
+ * Enters a position of the search of autoMove, which determines how good the current state may turn out to be
+ * for the specified player. It does this by looking ahead until the state stack is level deep. It is assumed
+ * that both the specified player and the opponent may make the best move possible. alpha and beta are used for
+ * alpha-beta cutoff so that the game tree can be pruned to avoid searching unneccessary paths.
+ *
+ * The worst goodness that the current state can produce in the number of moves (levels) searched is what the
+ * position is worth. This is the best the specified player can hope to achieve with this state (since it is
+ * assumed that the opponent will make the best moves possible). If it is known without searching any further it
+ * is returned, otherwise a frame for the position is pushed on the stack for _evaluateSteps and null is returned.
+ * @private
+ */
+Connect4Game.prototype._evaluateEnter = function(stack, player, level, alpha, beta) {
+    var depth = this._stateStack.length, tracer = this._tracer, node = null, result, value, key = null, known;
+
+    this._metrics.nodes++;
+
+    // a search that went over its budget is thrown away, so it unwinds as fast as it can
+    if (this._budget && this._checkBudget()) {
+        return 0;
+    }
+
+    if (tracer) {
+        node = this._traceEnter(tracer, depth, alpha, beta);
+    }
+
+    if (this._tablebaseReader && (value = this._probeTablebase(this._other(player))) !== Connect4Tablebase.UNKNOWN &&
+            value !== Connect4Tablebase.DRAW) {
+        // the tablebase already knows who wins from here, and it is the other player's turn
+        result = value === Connect4Tablebase.WIN ? -(Number.MAX_VALUE) : Number.MAX_VALUE;
+    }
+    else if (level === depth) {
+        result = this._goodnessOf(player);
+    }
+    else if ((key = this._tableKey('e', this._other(player))) !== null &&
+            (known = this._probeTable(key, level - depth, alpha, beta)) !== null) {
+        result = -known;
+    }
+    else {
+        /* Assume it is the other player's turn. */
+        stack.push({ player: player, level: level, depth: depth, alpha: alpha, beta: beta, best: -(Number.MAX_VALUE),
+                     maxab: alpha, next: 0, key: key, node: node, waiting: false, cutoff: false });
+        return null;
+    }
+
+    if (tracer) {
+        this._traceLeave(tracer, node, result);
+    }
+
+    return result;
+};
+
+/**
+ * Searches the positions entered by _evaluateEnter until move.stack is empty or the metrics count the given
+ * number of nodes. Each frame of the stack holds the window, the best goodness so far and the next move to try
+ * of one position, and a frame is waiting while the position after its last move is being searched on top of
+ * it. The goodness of the last position left is put in move.value.
+ * @private
+ */
+Connect4Game.prototype._evaluateSteps = function(move, limit) {
+    var stack = move.stack, tracer = this._tracer, frame, other, column, goodness;
+
+    while (stack.length > 0 && this._metrics.nodes < limit) {
+        frame = stack[stack.length - 1];
+        other = this._other(frame.player);
+
+        // the position on top of this frame has just been searched
+        if (frame.waiting) {
+            frame.waiting = false;
+            this._evaluateScore(frame, move.value);
+        }
+
+        while (!frame.waiting && !frame.cutoff && frame.next < this._cols) {
+            this._pushState();
+
+            column = this._dropOrder[frame.next++];
+            if (this._dropPiece(other, column) < 0) {
+                this._popState();
+                continue;
+            }
+
+            if (tracer) {
+                frame.node[6].push(column);
+            }
+
+            if (this.currentState.winner === other) {
+                this._evaluateScore(frame, Number.MAX_VALUE - frame.depth);
+            }
+            else if ((goodness = this._evaluateEnter(stack, other, frame.level, -frame.beta, -frame.maxab)) !== null) {
+                this._evaluateScore(frame, goodness);
+            }
+            else {
+                frame.waiting = true;
+            }
+        }
+
+        if (!frame.waiting) {
+            stack.pop();
+            if (frame.key !== null && !(this._budget && this._budget.exceeded)) {
+                this._storeTable(frame.key, frame.level - frame.depth, frame.alpha, frame.beta, frame.best);
+            }
+
+            // What's good for the other player is bad for this one
+            move.value = -frame.best;
+
+            if (tracer) {
+                this._traceLeave(tracer, frame.node, move.value);
+            }
+        }
+    }
+};
+
+/**
+ * Takes the goodness of the position after the last move tried by a frame of _evaluateSteps.
+ * @private
+ */
+Connect4Game.prototype._evaluateScore = function(frame, goodness) {
+    if (goodness > frame.best) {
+        frame.best = goodness;
+        if (frame.best > frame.maxab) {
+            frame.maxab = frame.best;
+        }
+    }
+
+    this._popState();
+    if (frame.best > frame.beta) {
+        if (this._tracer) {
+            frame.node[7] = frame.node[6].length - 1;
+        }
+        frame.cutoff = true;
+    }
+};
+
+/**
+ * Records a node being entered in a search trace.
+ * @private
+ */
+Connect4Game.prototype._traceEnter = function(tracer, depth, alpha, beta) {
+    var parent = tracer.parent >= 0 ? tracer.nodes[tracer.parent] : null,
+        column = parent ? parent[6][parent[6].length-1] : tracer.column,
+        node   = [this.positionKey(), tracer.parent, column, depth, alpha, beta, [], -1, 0, 0];
+
+    tracer.parent = tracer.nodes.length;
+    tracer.nodes.push(node);
+    return node;
+};
+
+/**
+ * Records a node being left in a search trace.
+ * @private
+ */
+Connect4Game.prototype._traceLeave = function(tracer, node, score) {
+    node[8] = score;
+    node[9] = tracer.nodes.length - tracer.parent;
+    tracer.parent = node[1];
+};
+
+/**
+ * Builds the key of the current position and of its mirror image and returns the smaller of the two. Each
+ * column is written bottom to top as the players occupying it, columns are separated by a pipe. This is the one
+ * definition of the key: the book, positionKey and indexGames all go through here, and Connect4Archive._key on
+ * the page, which builds it from a line of play without a board, has to give the same key for the archives it
+ * queries to match.
+ * @private
+ *
+ * @returns {object} An object with the canonical key, whether it was taken from the mirror image as mirrored and
+ *                   whether the position is its own mirror image as symmetric.
+ */
+Connect4Game.prototype._positionKey = function() {
+    var columns  = this._columnCodes(),
+        key      = columns.join('|'),
+        mirror   = columns.reverse().join('|'),
+        mirrored = mirror < key;
+
+    return { key: mirrored ? mirror : key, mirrored: mirrored, symmetric: mirror === key };
+};
+
+/**
+ * Gets the pieces of each column of the current position from the bottom up, as strings.
+ * @private
+ */
+Connect4Game.prototype._columnCodes = function() {
+    var board   = this.currentState.board,
+        columns = [];
+
+    for (var i=0; i<this._cols; i++) {
+        var column = board[i], code = '';
+        for (var j=0; j<this._rows && column[j] !== this._none; j++) {
+            code += column[j];
+        }
+        columns[i] = code;
+    }
+    return columns;
+};
+
+/**
+ * Replays a game from the empty board for indexGames. The moves are played on a single copy of the state, as
+ * nothing needs taking back but the whole game.
+ * @private
+ *
+ * @returns {object} An object with the state at the end of the game and the positions passed through as
+ *                   [key, column] pairs, the column being the one played next in the position of the key or -1
+ *                   after the last move, or null if a move is not valid.
+ */
+Connect4Game.prototype._indexLine = function(moves, depth) {
+    var positions = [], state;
+
+    this._pushState();
+    for (var i=0; i<=moves.length; i++) {
+        var column = i < moves.length ? moves[i][1] : -1;
+        if (depth == null || i <= depth) {
+            var position = this._positionKey();
+
+            if (column >= 0 && (position.mirrored || (position.symmetric && this._cols - 1 - column < column))) {
+                positions.push([position.key, this._cols - 1 - column]);
+            }
+            else {
+                positions.push([position.key, column]);
+            }
+        }
+        if (i === moves.length) {
+            break;
+        }
+        if (this.currentState.gameOver || column < 0 || column >= this._cols ||
+                this._dropPiece(moves[i][0], column) < 0) {
+            positions = null;
+            break;
+        }
+    }
+    state = this.currentState;
+    this._popState();
+
+    return positions && { state: state, positions: positions };
+};
+
+/**
+ * Counts the current position for perft. A position whose moves are still to be counted gets a frame on the
+ * stack of the count, for continuePerft to play them one by one.
+ * @private
+ *
+ * @returns {boolean} Whether the position got a frame, and so keeps its state until its moves are counted.
+ */
+Connect4Game.prototype._perftEnter = function(run, player, depth) {
+    var over = this.currentState.gameOver;
+
+    run.counts.visited++;
+    if (over) {
+        run.counts.terminal++;
+    }
+    if (depth === 0) {
+        run.counts.nodes++;
+        if (run.keys) {
+            run.keys[this._columnCodes().join('|')] = true;
+        }
+        return false;
+    }
+    else if (over) {
+        return false;
+    }
+
+    run.stack.push({ player: player, depth: depth, next: 0 });
+    return true;
+};
+
+/**
+ * Looks up the current position in the opening book. The book is a plain object, so the lookup is a single
+ * hashed property access no matter how many positions it holds.
+ * @private
+ *
+ * @returns {number} The column the book suggests or -1 if the position is not in the book.
+ */
+Connect4Game.prototype._bookMove = function() {
+    if (!this._book) {
+        return -1;
+    }
+
+    var position = this._positionKey();
+    if (!Object.prototype.hasOwnProperty.call(this._book, position.key)) {
+        return -1;
+    }
+
+    var column = this._book[position.key];
+    if (position.mirrored) {
+        column = this._cols - 1 - column;
+    }
+
+    // ignore entries that do not fit the board or point at a full column
+    if (column < 0 || column >= this._cols || this.currentState.board[column][this._rows-1] !== this._none) {
+        return -1;
+    }
+
+    return column;
+};
+
+/**
+ * Only the geometry and the current state are needed by the main interface. Everything else (such as the
+ * opening book) stays in the worker rather than being copied back on every message.
+ * @private
+ */
+Connect4Game.prototype.toJSON = function() {
+    return {
+        _cols: this._cols,
+        _rows: this._rows,
+        _connect: this._connect,
+        positionKey: this.positionKey(),
+        currentState: this.currentState
+    };
+};
+
+/**
+ * Searches the solve in progress for up to the given number of positions. This is a plain alpha-beta search
+ * that looks all the way to the end of the game, with the stack of positions being searched kept in
+ * search.stack: each frame holds the window, the best score so far and the next move to try of one position,
+ * and a frame is waiting while the position after its last move is being searched on top of it. The score
+ * returned for a position is only exact when it falls within alpha and beta; otherwise it is a bound.
+ * @private
+ */
+Connect4Game.prototype._solveSteps = function(search, budget) {
+    var stack = search.stack, limit = this._nodes + budget, frame, score;
+
+    while (stack.length > 0 && this._nodes < limit) {
+        frame = stack[stack.length - 1];
+
+        // the position on top of this frame has just been solved
+        if (frame.waiting) {
+            frame.waiting = false;
+            this._popState();
+            this._solveScore(frame, -search.value);
+        }
+
+        while (!frame.waiting && !frame.cutoff && frame.move < this._cols) {
+            this._pushState();
+
+            if (this._dropPiece(frame.player, this._dropOrder[frame.move++]) < 0) {
+                this._popState();
+            }
+            else if (this.currentState.winner === frame.player) {
+                this._popState();
+                this._solveScore(frame, frame.empty);
+            }
+            else if ((score = this._solveEnter(stack, this._other(frame.player), -frame.beta, -frame.alpha)) !== null) {
+                this._popState();
+                this._solveScore(frame, -score);
+            }
+            else {
+                frame.waiting = true;
+            }
+        }
+
+        if (!frame.waiting) {
+            stack.pop();
+            if (frame.key !== null) {
+                this._storeTable(frame.key, frame.empty, frame.lower + 1, frame.beta - 1, frame.best);
+            }
+            search.value = frame.best;
+        }
+    }
+};
+
+/**
+ * Enters a position of the solve. If its score is known without searching it is returned, otherwise a frame
+ * for it is pushed on the stack and null is returned.
+ * @private
+ */
+Connect4Game.prototype._solveEnter = function(stack, player, alpha, beta) {
+    var empty = this._cols * this._rows - this.currentState.numberOfPieces;
+
+    this._nodes++;
+
+    // a full board is a draw
+    if (empty === 0) {
+        return 0;
+    }
+
+    // a win or a loss from the tablebase still has to be searched for its score, but within a narrower window
+    if (this._tablebaseReader) {
+        var value = this._probeTablebase(player);
+        if (value === Connect4Tablebase.DRAW) {
+            return 0;
+        }
+        else if (value === Connect4Tablebase.WIN) {
+            if (beta <= 1) {
+                return 1;
+            }
+            alpha = Math.max(alpha, 1);
+        }
+        else if (value === Connect4Tablebase.LOSS) {
+            if (alpha >= -1) {
+                return -1;
+            }
+            beta = Math.min(beta, -1);
+        }
+    }
+
+    // scores are whole numbers, so the window is narrowed by one to match the bounds of the heuristic search,
+    // where only values strictly outside the window are bounds
+    var key = this._tableKey('s', player), known;
+    if (key !== null && (known = this._probeTable(key, empty, alpha + 1, beta - 1)) !== null) {
+        return known;
+    }
+
+    stack.push({
+        player: player, alpha: alpha, beta: beta, lower: alpha, best: -(empty + 1), empty: empty, key: key,
+        move: 0, waiting: false, cutoff: false
+    });
+    return null;
+};
+
+/**
+ * Takes the score of one of the moves of a frame into account.
+ * @private
+ */
+Connect4Game.prototype._solveScore = function(frame, score) {
+    if (score > frame.best) {
+        frame.best = score;
+        if (frame.best > frame.alpha) {
+            frame.alpha = frame.best;
+        }
+        if (frame.alpha >= frame.beta) {
+            frame.cutoff = true;
+        }
+    }
+};
+
+/**
+ * Plays the given moves on top of the current state without touching the states below it.
+ * @private
+ *
+ * @param {array} moves The moves to play as [player, column] pairs.
+ *
+ * @returns {number} The depth of the state stack to take back to with _takeBack.
+ *
+ * @throws An error if one of the moves is not valid.
+ */
+Connect4Game.prototype._playMoves = function(moves) {
+    var depth = this._stateStack.length;
+
+    for (var i=0; i<moves.length; i++) {
+        this._pushState();
+        if (this._dropPiece(moves[i][0], moves[i][1]) < 0) {
+            this._takeBack(depth);
+            throw new Error('Not a valid move.');
+        }
+    }
+
+    return depth;
+};
+
+/**
+ * Pops states until the state stack is back to the given depth.
+ * @private
+ */
+Connect4Game.prototype._takeBack = function(depth) {
+    while (this._stateStack.length > depth) {
+        this._popState();
+    }
+};
+
+/**
+ * Looks up the current state in the tablebase for the given player to move. Tablebases assume the players take
+ * turns starting with player 1, so any other player to move is unknown.
+ * @private
+ *
+ * @returns {number} One of the Connect4Tablebase values.
+ */
+Connect4Game.prototype._probeTablebase = function(player) {
+    if (player !== this.currentState.numberOfPieces % 2) {
+        return Connect4Tablebase.UNKNOWN;
+    }
+    return this._tablebaseReader.probe(this.currentState.board);
+};
+
+/**
+ * Gets the transposition table key of the current state for the given player to move, prefixed by the kind of
+ * search, since the values of different searches do not mix.
+ * @private
+ *
+ * @returns {string} The key, or null if there are no transposition tables.
+ */
+Connect4Game.prototype._tableKey = function(kind, player) {
+    return this._deepTable ? kind + player + this.positionKey() : null;
+};
+
+/**
+ * Starts a new generation in the transposition tables, see Connect4Table#age.
+ * @private
+ */
+Connect4Game.prototype._ageTables = function() {
+    if (this._deepTable) {
+        this._deepTable.age();
+        this._shallowTable !== this._deepTable && this._shallowTable.age();
+    }
+};
+
+/**
+ * Looks up a key in the transposition table for its remaining depth and checks whether what is known settles
+ * the value within the window. As in _evaluateSteps, only values strictly outside the window are bounds. Values
+ * are from the point of view of the player to move.
+ * @private
+ *
+ * @returns {number} The value, or null if the node has to be searched.
+ */
+Connect4Game.prototype._probeTable = function(key, remaining, alpha, beta) {
+    // entries searched deeper than needed come from earlier searches, and would make the result depend on them
+    var table = remaining <= this._shallowDepth ? this._shallowTable : this._deepTable,
+        entry = table.probe(key, remaining, this._seed !== null, this._session);
+
+    if (entry && (entry.flag === Connect4Table.EXACT ||
+            (entry.flag === Connect4Table.LOWER && entry.value > beta) ||
+            (entry.flag === Connect4Table.UPPER && entry.value < alpha))) {
+        return entry.value;
+    }
+    return null;
+};
+
+/**
+ * Stores the value of a searched node in the transposition table for its remaining depth. A value above the
+ * window came from a cutoff and is a lower bound, one below it means every move failed low and it is an upper
+ * bound.
+ * @private
+ */
+Connect4Game.prototype._storeTable = function(key, remaining, alpha, beta, value) {
+    var table = remaining <= this._shallowDepth ? this._shallowTable : this._deepTable,
+        flag  = value > beta ? Connect4Table.LOWER : value < alpha ? Connect4Table.UPPER : Connect4Table.EXACT;
+
+    table.store(key, remaining, value, flag, this._session);
+};
+
+/**
+ * Recursive helper for frontier.
+ * @private
+ */
+Connect4Game.prototype._expandFrontier = function(player, depth, path, frontier) {
+    var empty = this._cols * this._rows - this.currentState.numberOfPieces;
+
+    if (empty === 0) {
+        frontier.push({ path: path.slice(0), score: 0 });
+        return;
+    }
+    else if (depth === 0) {
+        frontier.push({ path: path.slice(0) });
+        return;
+    }
+
+    for (var i=0; i<this._cols; i++) {
+        this._pushState();
+
+        if (this._dropPiece(player, this._dropOrder[i]) >= 0) {
+            path.push(this._dropOrder[i]);
+            if (this.currentState.winner === player) {
+                // the player to move at the end of this path has already lost
+                frontier.push({ path: path.slice(0), score: -empty });
+            }
+            else {
+                this._expandFrontier(this._other(player), depth-1, path, frontier);
+            }
+            path.pop();
+        }
+
+        this._popState();
     }
 };
 
@@ -510,7 +2176,7 @@ Connect4Game.prototype._setupDropOrder = function() {
     // by ordering the search such that the centeral columns are
     // tried frist, alpha-beta cutoff is much more effective
     this._dropOrder = [];
-    var column = (this._cols-1) / 2;
+    var column = Math.floor((this._cols-1) / 2);
     for (var i=1; i<=this._cols; i++) {
         this._dropOrder[i-1] = column;
         column += ((i%2) ? i : -i);
@@ -0,0 +1,221 @@
+/*!
+ * Copyright 2010, Brandon Aaron (http://brandonaaron.net/)
+ *
+ * Licensed under the MIT license: LICENSE.txt.
+ */
+
+/**
+ * @fileOverview This file is imported via the Connect4Worker.js and provides the transposition tables used by the
+ * searches in Connect4Game.js.
+ */
+
+/**
+ * A fixed size transposition table. Each key hashes to a single slot which holds the value found for that key,
+ * how deep it was searched and whether the value is exact or only a bound. When a slot is taken by another key
+ * the replacement policy decides who keeps it: 'always' lets the newest entry in, which suits small tables of
+ * cheap entries, while 'depth' only lets in entries searched at least as deep as the one already there.
+ *
+ * A table can be shared by several games. Every entry is tagged with the game (the owner) that stored it and the
+ * generation it was stored in, the generation going up with every search made with the table (see age). Under
+ * the 'depth' policy an entry more than maxAge generations old gives way to any other, so that deep entries from
+ * long finished searches do not hold on to their slots for good.
+ *
+ * @param {number} size The number of slots.
+ * @param {string} [policy = 'always'] The replacement policy, 'always' or 'depth'.
+ *
+ * @property {number} probes The number of lookups.
+ * @property {number} hits The number of lookups that found their key.
+ * @property {number} stores The number of entries stored.
+ * @property {number} replaced The number of entries that pushed out an entry for another key.
+ * @property {number} rejected The number of entries the replacement policy kept out.
+ * @property {number} filled The number of slots in use.
+ * @property {number} crossHits The number of hits on entries stored by another owner.
+ * @property {number} generation The current generation.
+ * @property {number} maxAge How many generations old an entry may get before it gives way to any other.
+ */
+function Connect4Table(size, policy) {
+    this.size = size;
+    this.policy = policy || 'always';
+
+    this._keys = [];
+    this._depths = [];
+    this._values = [];
+    this._flags = [];
+    this._owners = [];
+    this._generations = [];
+    for (var i=0; i<size; i++) {
+        this._keys[i] = null;
+        this._depths[i] = 0;
+        this._values[i] = 0;
+        this._flags[i] = 0;
+        this._owners[i] = 0;
+        this._generations[i] = 0;
+    }
+
+    this.probes = 0;
+    this.hits = 0;
+    this.stores = 0;
+    this.replaced = 0;
+    this.rejected = 0;
+    this.filled = 0;
+    this.crossHits = 0;
+    this.generation = 0;
+    this.maxAge = 16;
+
+    return this;
+}
+
+/**
+ * What a stored value means: the value itself, a lower bound or an upper bound.
+ */
+Connect4Table.EXACT = 0;
+Connect4Table.LOWER = 1;
+Connect4Table.UPPER = 2;
+
+/**
+ * Looks up a key searched at least the given depth.
+ *
+ * @param {string} key The key.
+ * @param {number} depth The least depth the entry must have been searched to.
+ * @param {boolean} [exact = false] Whether the entry must have been searched to exactly the given depth.
+ * @param {number} [owner = 0] Who is looking, to count the hits on entries stored by others.
+ *
+ * @returns {object} An object with the value, depth and flag of the entry, or null if there is none.
+ */
+Connect4Table.prototype.probe = function(key, depth, exact, owner) {
+    var slot = this._slot(key);
+
+    this.probes++;
+    if (this._keys[slot] !== key || this._depths[slot] < depth || (exact && this._depths[slot] !== depth)) {
+        return null;
+    }
+
+    this.hits++;
+    if (this._owners[slot] !== (owner || 0)) {
+        this.crossHits++;
+    }
+    return { value: this._values[slot], depth: this._depths[slot], flag: this._flags[slot] };
+};
+
+/**
+ * Stores an entry, subject to the replacement policy.
+ *
+ * @param {string} key The key.
+ * @param {number} depth How deep the value was searched.
+ * @param {number} value The value.
+ * @param {number} flag One of EXACT, LOWER or UPPER.
+ * @param {number} [owner = 0] Who is storing it.
+ */
+Connect4Table.prototype.store = function(key, depth, value, flag, owner) {
+    var slot = this._slot(key), current = this._keys[slot];
+
+    if (current !== null && current !== key) {
+        if (this.policy === 'depth' && depth < this._depths[slot] &&
+                this.generation - this._generations[slot] <= this.maxAge) {
+            this.rejected++;
+            return;
+        }
+        this.replaced++;
+    }
+    else if (current === null) {
+        this.filled++;
+    }
+
+    this.stores++;
+    this._keys[slot] = key;
+    this._depths[slot] = depth;
+    this._values[slot] = value;
+    this._flags[slot] = flag;
+    this._owners[slot] = owner || 0;
+    this._generations[slot] = this.generation;
+};
+
+/**
+ * Starts a new generation, which every search does before it uses the table.
+ */
+Connect4Table.prototype.age = function() {
+    this.generation++;
+};
+
+/**
+ * Gets the entries stored by an owner, the most recent generations first and the deepest first within a
+ * generation, as [key, depth, value, flag] arrays.
+ *
+ * @param {number} [owner = 0] The owner.
+ * @param {number} [count] The most entries to return, all of them by default.
+ *
+ * @returns {array} The entries.
+ */
+Connect4Table.prototype.entries = function(owner, count) {
+    var slots = [], entries = [];
+
+    for (var i=0; i<this.size; i++) {
+        if (this._keys[i] !== null && this._owners[i] === (owner || 0)) {
+            slots.push(i);
+        }
+    }
+
+    var generations = this._generations, depths = this._depths;
+    slots.sort(function(a, b) {
+        return generations[b] - generations[a] || depths[b] - depths[a];
+    });
+
+    for (var i=0; i<slots.length && (count === undefined || i < count); i++) {
+        entries.push([this._keys[slots[i]], depths[slots[i]], this._values[slots[i]], this._flags[slots[i]]]);
+    }
+    return entries;
+};
+
+/**
+ * Stores entries as returned by entries, subject to the replacement policy.
+ *
+ * @param {array} entries The entries.
+ * @param {number} [owner = 0] Who they are stored for.
+ */
+Connect4Table.prototype.load = function(entries, owner) {
+    // the least valuable go first, so that they are the ones to give way when two want the same slot
+    for (var i=entries.length-1; i>=0; i--) {
+        this.store(entries[i][0], entries[i][1], entries[i][2], entries[i][3], owner);
+    }
+};
+
+/**
+ * Gets the statistics of the table.
+ *
+ * @returns {object} The size of the table and the counters described in the constructor.
+ */
+Connect4Table.prototype.stats = function() {
+    return {
+        size: this.size,
+        probes: this.probes,
+        hits: this.hits,
+        stores: this.stores,
+        replaced: this.replaced,
+        rejected: this.rejected,
+        filled: this.filled,
+        crossHits: this.crossHits
+    };
+};
+
+/**
+ * Hashes a string to a 32 bit unsigned integer.
+ *
+ * @param {string} key The string.
+ *
+ * @returns {number} The hash.
+ */
+Connect4Table.hash = function(key) {
+    var hash = 0;
+    for (var i=0, length=key.length; i<length; i++) {
+        hash = (hash * 31 + key.charCodeAt(i)) | 0;
+    }
+    return hash >>> 0;
+};
+
+/**
+ * Hashes a key to its slot.
+ * @private
+ */
+Connect4Table.prototype._slot = function(key) {
+    return Connect4Table.hash(key) % this.size;
+};
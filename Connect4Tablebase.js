@@ -0,0 +1,416 @@
+/*!
+ * Copyright 2010, Brandon Aaron (http://brandonaaron.net/)
+ *
+ * Licensed under the MIT license: LICENSE.txt.
+ */
+
+/**
+ * @fileOverview This file is imported via the Connect4Worker.js and provides random access to compressed tables of
+ * win/draw/loss values, such as the ones produced by solving every position of a small board.
+ */
+
+/**
+ * Opens a compressed table of win/draw/loss values for random access. Every position of the board has an index
+ * (see Connect4Tablebase.index) and each value takes two bits, the values being kept in blocks of consecutive
+ * indices. Each block is stored on its own, either range coded or packed four values to a byte, whichever is
+ * smaller. The range coder predicts each value from the one before it, so the long runs of positions that cannot
+ * occur in a game cost next to nothing and a block is never stored in more than two bits a value. A probe only
+ * decodes the block it needs, and the most recently used decoded blocks are kept around.
+ *
+ * The table itself is a plain object that survives JSON, as returned by Connect4Tablebase.build:
+ * version: see Connect4Tablebase.version,
+ * cols, rows, connect: the geometry of the board,
+ * blockSize: the number of indices in a block,
+ * blocks: the numbers of the blocks stored, in order, blocks without any known value are left out,
+ * offsets: where each block starts in the data, with the end of the data last,
+ * data: the blocks one after the other, as bytes written in base64. Only the container is written that way, for
+ *       JSON, which costs a third more than the bytes themselves; the data can as well be given as a Uint8Array
+ *       holding the bytes, read from a binary file for instance.
+ *
+ * @param {object} table The table.
+ * @param {number} [cacheSize = 64] The number of decoded blocks to keep.
+ *
+ * @throws An error if the table is of another version.
+ */
+function Connect4Tablebase(table, cacheSize) {
+    if (table.version !== Connect4Tablebase.version) {
+        throw new Error('Not a tablebase of this version.');
+    }
+
+    this._table = table;
+    this._bytes = typeof table.data === 'string' ? Connect4Tablebase._fromBase64(table.data) : table.data;
+    this._cacheSize = cacheSize || 64;
+    // the place of each stored block in blocks and offsets, by number
+    this._blocks = {};
+    for (var i=0; i<table.blocks.length; i++) {
+        this._blocks[table.blocks[i]] = i;
+    }
+    // the decoded blocks by number, each in a list from the least to the most recently used
+    this._cache = {};
+    this._cached = 0;
+    this._oldest = null;
+    this._newest = null;
+
+    this.hits = 0;
+    this.misses = 0;
+
+    return this;
+}
+
+/**
+ * The version of the tables built by Connect4Tablebase.build.
+ */
+Connect4Tablebase.version = 2;
+
+/**
+ * The values stored in a table. Values are always from the point of view of the player to move.
+ */
+Connect4Tablebase.UNKNOWN = 0;
+Connect4Tablebase.LOSS = 1;
+Connect4Tablebase.DRAW = 2;
+Connect4Tablebase.WIN = 3;
+
+/**
+ * The characters the data of a table is written with in base64, six bits each.
+ * @private
+ */
+Connect4Tablebase._digits = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+
+/**
+ * Gets the index of a position. Each column is coded as a one followed by the players occupying it from the
+ * bottom up, so a column of height h takes one of 2^h codes and all columns together fit in 2^(rows+1) - 1.
+ * The index is the number those codes make in that base. A position and its mirror image share the smaller of
+ * their indices.
+ *
+ * @param {array} board The board, as in Connect4Game#currentState.
+ * @param {number} cols The number of columns.
+ * @param {number} rows The number of rows.
+ *
+ * @returns {number} The index of the position.
+ */
+Connect4Tablebase.index = function(board, cols, rows) {
+    var radix  = (1 << (rows + 1)) - 1,
+        index  = 0,
+        mirror = 0;
+
+    for (var i=0; i<cols; i++) {
+        var column = board[i], code = 1;
+        for (var j=0; j<rows && column[j] !== -1; j++) {
+            code = (code << 1) | column[j];
+        }
+        // codes start at 1 for an empty column
+        index = index * radix + code - 1;
+        mirror += (code - 1) * Math.pow(radix, i);
+    }
+
+    return Math.min(index, mirror);
+};
+
+/**
+ * Gets the value to store for a score from Connect4Game#solve.
+ *
+ * @param {number} score The score.
+ *
+ * @returns {number} The value.
+ */
+Connect4Tablebase.value = function(score) {
+    return score > 0 ? Connect4Tablebase.WIN : score < 0 ? Connect4Tablebase.LOSS : Connect4Tablebase.DRAW;
+};
+
+/**
+ * Builds a table from a list of values.
+ *
+ * @param {object} settings The geometry of the board: cols, rows and connect.
+ * @param {array} entries The values as [index, value] pairs, in any order.
+ * @param {number} [blockSize = 4096] The number of indices in a block.
+ *
+ * @returns {object} The table.
+ *
+ * @throws An error if the indices of the board cannot be represented exactly.
+ */
+Connect4Tablebase.build = function(settings, entries, blockSize) {
+    blockSize = blockSize || 4096;
+
+    if (Math.pow((1 << (settings.rows + 1)) - 1, settings.cols) > 9007199254740992) {
+        throw new Error('The board is too large for a table.');
+    }
+
+    var values  = {},
+        numbers = [],
+        data    = [],
+        table   = { version: Connect4Tablebase.version, cols: settings.cols, rows: settings.rows,
+                    connect: settings.connect, blockSize: blockSize, blocks: [], offsets: [] };
+
+    for (var i=0; i<entries.length; i++) {
+        var block = Math.floor(entries[i][0] / blockSize);
+        if (!values[block]) {
+            values[block] = [];
+            numbers.push(block);
+            for (var j=0; j<blockSize; j++) {
+                values[block][j] = Connect4Tablebase.UNKNOWN;
+            }
+        }
+        values[block][entries[i][0] - block * blockSize] = entries[i][1];
+    }
+
+    numbers.sort(function(a, b) { return a - b; });
+    for (var i=0; i<numbers.length; i++) {
+        table.blocks.push(numbers[i]);
+        table.offsets.push(data.length);
+        data.push.apply(data, Connect4Tablebase._encode(values[numbers[i]]));
+    }
+    table.offsets.push(data.length);
+    table.data = Connect4Tablebase._toBase64(data);
+
+    return table;
+};
+
+/**
+ * Looks up the value of a position.
+ *
+ * @param {array} board The board, as in Connect4Game#currentState.
+ *
+ * @returns {number} The value of the position for the player to move, or UNKNOWN.
+ */
+Connect4Tablebase.prototype.probe = function(board) {
+    var table  = this._table,
+        index  = Connect4Tablebase.index(board, table.cols, table.rows),
+        number = Math.floor(index / table.blockSize),
+        block  = this._cache[number];
+
+    if (block) {
+        this.hits++;
+        this._unlink(block);
+    }
+    else if (!this._blocks.hasOwnProperty(number)) {
+        return Connect4Tablebase.UNKNOWN;
+    }
+    else {
+        var place = this._blocks[number];
+        this.misses++;
+        block = this._cache[number] = {
+            number: number,
+            values: Connect4Tablebase._decode(this._bytes, table.offsets[place], table.offsets[place + 1],
+                table.blockSize),
+            older: null,
+            newer: null
+        };
+        if (++this._cached > this._cacheSize) {
+            var oldest = this._oldest;
+            this._unlink(oldest);
+            delete this._cache[oldest.number];
+            this._cached--;
+        }
+    }
+
+    // the block goes to the most recently used end
+    block.older = this._newest;
+    block.newer = null;
+    this._newest ? (this._newest.newer = block) : (this._oldest = block);
+    this._newest = block;
+
+    return block.values[index - number * table.blockSize];
+};
+
+/**
+ * Takes a cached block out of the list of blocks by use.
+ * @private
+ */
+Connect4Tablebase.prototype._unlink = function(block) {
+    block.older ? (block.older.newer = block.newer) : (this._oldest = block.newer);
+    block.newer ? (block.newer.older = block.older) : (this._newest = block.older);
+    block.older = block.newer = null;
+};
+
+/**
+ * The probabilities of the range coder are in 1/2048ths, and move a 32nd of the way towards each bit coded.
+ * @private
+ */
+Connect4Tablebase._probabilityBits = 11;
+Connect4Tablebase._adaptation = 5;
+
+/**
+ * Encodes the values of a block as bytes, range coded if that is shorter and otherwise packed, four values to a
+ * byte from the highest bits down. A packed block takes exactly a byte for every four values, which is how the
+ * decoder tells them apart. The range coder is the binary one of LZMA: each value is coded as its two bits, the
+ * high one first, with a probability of its own for each bit, each value of the high bit and each value before
+ * it. The probabilities start even and adapt as the block goes, so a block costs about as many bits as the
+ * values tell, given the one before, and the decoder learns them the same way.
+ * @private
+ */
+Connect4Tablebase._encode = function(values) {
+    var packed = [], coded = [], coder = Connect4Tablebase._encoder(coded), models = Connect4Tablebase._models(),
+        previous = 0;
+
+    for (var i=0; i<values.length; i+=4) {
+        packed.push(values[i] << 6 | (values[i+1] || 0) << 4 | (values[i+2] || 0) << 2 | (values[i+3] || 0));
+    }
+
+    for (var i=0; i<values.length; i++) {
+        var model = models[previous], high = values[i] >> 1;
+        coder.bit(model, 0, high);
+        coder.bit(model, 1 + high, values[i] & 1);
+        previous = values[i];
+    }
+    coder.flush();
+
+    return coded.length < packed.length ? coded : packed;
+};
+
+/**
+ * Decodes the values of the block between two offsets of the data of a table.
+ * @private
+ */
+Connect4Tablebase._decode = function(bytes, start, end, size) {
+    var values = [];
+
+    if (end - start === Math.ceil(size / 4)) {
+        for (var i=start; i<end; i++) {
+            values.push(bytes[i] >> 6, (bytes[i] >> 4) & 3, (bytes[i] >> 2) & 3, bytes[i] & 3);
+        }
+    }
+    else {
+        var decoder = Connect4Tablebase._decoder(bytes, start, end), models = Connect4Tablebase._models(),
+            previous = 0;
+        for (var i=0; i<size; i++) {
+            var model = models[previous], high = decoder.bit(model, 0);
+            previous = values[i] = high << 1 | decoder.bit(model, 1 + high);
+        }
+    }
+
+    values.length = size;
+    return values;
+};
+
+/**
+ * Creates the probabilities of the range coder for a block: for each value before, one for the high bit and one
+ * for the low bit after each value of the high bit.
+ * @private
+ */
+Connect4Tablebase._models = function() {
+    var models = [], half = 1 << (Connect4Tablebase._probabilityBits - 1);
+    for (var i=0; i<4; i++) {
+        models.push([half, half, half]);
+    }
+    return models;
+};
+
+/**
+ * Creates a range encoder writing to an array of bytes. The low end of the range is kept in a number with room
+ * above 32 bits for the carry, which goes into the last byte written, or the run of 255s after it, once known.
+ * @private
+ */
+Connect4Tablebase._encoder = function(out) {
+    var low = 0, range = 0xFFFFFFFF, cache = 0, pending = 1,
+        bits = Connect4Tablebase._probabilityBits, adaptation = Connect4Tablebase._adaptation;
+
+    function shift() {
+        if (low < 0xFF000000 || low >= 0x100000000) {
+            var carry = low >= 0x100000000 ? 1 : 0, byte = cache;
+            for (; pending > 0; pending--) {
+                out.push((byte + carry) & 0xFF);
+                byte = 0xFF;
+            }
+            cache = Math.floor(low / 0x1000000) & 0xFF;
+        }
+        pending++;
+        low = (low & 0xFFFFFF) * 256;
+    }
+
+    return {
+        bit: function(model, i, bit) {
+            var bound = (range >>> bits) * model[i];
+            if (bit) {
+                low += bound;
+                range -= bound;
+                model[i] -= model[i] >> adaptation;
+            }
+            else {
+                range = bound;
+                model[i] += ((1 << bits) - model[i]) >> adaptation;
+            }
+            for (; range < 0x1000000; range *= 256) {
+                shift();
+            }
+        },
+        flush: function() {
+            for (var i=0; i<5; i++) {
+                shift();
+            }
+        }
+    };
+};
+
+/**
+ * Creates a range decoder reading the bytes between two offsets, see _encoder. Bytes past the end read as 0.
+ * @private
+ */
+Connect4Tablebase._decoder = function(bytes, start, end) {
+    var code = 0, range = 0xFFFFFFFF, next = start,
+        bits = Connect4Tablebase._probabilityBits, adaptation = Connect4Tablebase._adaptation;
+
+    function read() {
+        return next < end ? bytes[next++] : 0;
+    }
+
+    // the first byte of the encoder is always 0
+    for (var i=0; i<5; i++) {
+        code = code * 256 + read();
+    }
+
+    return {
+        bit: function(model, i) {
+            var bound = (range >>> bits) * model[i], bit;
+            if (code < bound) {
+                range = bound;
+                model[i] += ((1 << bits) - model[i]) >> adaptation;
+                bit = 0;
+            }
+            else {
+                code -= bound;
+                range -= bound;
+                model[i] -= model[i] >> adaptation;
+                bit = 1;
+            }
+            for (; range < 0x1000000; range *= 256) {
+                code = code * 256 + read();
+            }
+            return bit;
+        }
+    };
+};
+
+/**
+ * Writes bytes in base64, with the characters of _digits.
+ * @private
+ */
+Connect4Tablebase._toBase64 = function(bytes) {
+    var digits = Connect4Tablebase._digits, encoded = '';
+
+    for (var i=0; i<bytes.length; i+=3) {
+        var triple = bytes[i] << 16 | (bytes[i+1] || 0) << 8 | (bytes[i+2] || 0);
+        encoded += digits.charAt(triple >> 18) + digits.charAt((triple >> 12) & 63) +
+            (i + 1 < bytes.length ? digits.charAt((triple >> 6) & 63) : '=') +
+            (i + 2 < bytes.length ? digits.charAt(triple & 63) : '=');
+    }
+    return encoded;
+};
+
+/**
+ * Reads bytes written in base64 by _toBase64.
+ * @private
+ */
+Connect4Tablebase._fromBase64 = function(encoded) {
+    var digits  = Connect4Tablebase._digits,
+        padding = encoded.charAt(encoded.length - 1) === '=' ? (encoded.charAt(encoded.length - 2) === '=' ? 2 : 1) : 0,
+        bytes   = new Uint8Array(encoded.length / 4 * 3 - padding);
+
+    for (var i=0, j=0; i<encoded.length; i+=4) {
+        var triple = digits.indexOf(encoded.charAt(i)) << 18 | digits.indexOf(encoded.charAt(i+1)) << 12 |
+            (digits.indexOf(encoded.charAt(i+2)) & 63) << 6 | (digits.indexOf(encoded.charAt(i+3)) & 63);
+        bytes[j++] = triple >> 16;
+        j < bytes.length && (bytes[j++] = (triple >> 8) & 0xFF);
+        j < bytes.length && (bytes[j++] = triple & 0xFF);
+    }
+    return bytes;
+};
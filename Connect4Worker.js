@@ -5,27 +5,172 @@
  */
  
 /**
- * @fileOverview This file is the Web Worker definition and imports the Connect4Game.js file. It is used by Connect4.js.
+ * @fileOverview This file is the Web Worker definition and imports the Connect4Game.js, Connect4Table.js and
+ * Connect4Tablebase.js files. It is used by Connect4.js, both for the worker of each game and for the workers of
+ * the shared pool. A pool worker keeps a replica of every game it has run tasks for, and messages for those say
+ * which game they are for.
  */
  
-importScripts('Connect4Game.js');
-var connect4;
+importScripts('Connect4Game.js', 'Connect4Table.js', 'Connect4Tablebase.js');
+var connect4, games = {}, runs = [];
+
+/**
+ * The actions that run in slices, with how to start one on a game and the methods of the game that carry it on
+ * and stop it. Between two slices the worker goes back to its message loop, so a stop sent while a long search is
+ * running gets through, and the pool can have another task run in between.
+ */
+var sliced = {
+    solvePosition: {
+        start: function(game, args) { game.startSolve(args[1], args[2], args[3], args[0], args[4]); },
+        next: 'continueSolve',
+        stop: 'stopSolve'
+    },
+    searchMove: {
+        start: function(game, args) { game.startSearch.apply(game, args); },
+        next: 'continueSearch',
+        stop: 'stopSearch'
+    },
+    perft: {
+        start: function(game, args) { game.startPerft.apply(game, args); },
+        next: 'continuePerft',
+        stop: 'stopPerft'
+    },
+    indexGames: {
+        start: function(game, args) { game.startIndex.apply(game, args); },
+        next: 'continueIndex',
+        stop: 'stopIndex'
+    }
+};
+
+/**
+ * Posts a reply, with the counters of the game piggybacked so the page always has recent ones without having to
+ * ask.
+ */
+function reply(game, ret) {
+    ret.metrics = game && game.metrics();
+    postMessage(JSON.stringify(ret));
+}
+
+/**
+ * Turns a reply into the one of an action that threw the given error.
+ */
+function fail(ret, e) {
+    ret.returnValue = null;
+    ret.error = String(e && e.message || e);
+}
+
+/**
+ * Starts a sliced action. A run started while another one is going on is a task the pool let in between two
+ * slices of it, so the other one waits until the new one is done.
+ */
+function startRun(game, action, args, ret) {
+    var run = { game: game, action: sliced[action], ret: ret, timer: null },
+        top = runs[runs.length - 1];
+
+    run.action.start(game, args);
+    if (top) {
+        clearTimeout(top.timer);
+        top.timer = null;
+    }
+    runs.push(run);
+    runSlice(run);
+}
+
+/**
+ * Runs the next slice of a run and replies once it is done. A run that throws is stopped, which puts its game
+ * back the way it was, and replies with the error.
+ */
+function runSlice(run) {
+    var result;
+    run.timer = null;
+    try {
+        result = run.game[run.action.next](run.game._sliceNodes);
+    }
+    catch (e) {
+        endRun(run);
+        run.game[run.action.stop]();
+        fail(run.ret, e);
+        reply(run.game, run.ret);
+        return;
+    }
+
+    if (!result.done) {
+        run.timer = setTimeout(function() { runSlice(run); }, 0);
+        return;
+    }
+
+    delete result.done;
+    endRun(run);
+    run.ret.returnValue = result;
+    reply(run.game, run.ret);
+}
+
+/**
+ * Takes a run off the stack, and carries on with the one it was in between if that one is now on top.
+ */
+function endRun(run) {
+    clearTimeout(run.timer);
+    runs.splice(runs.indexOf(run), 1);
+
+    var top = runs[runs.length - 1];
+    if (top && !top.timer) {
+        top.timer = setTimeout(function() { runSlice(top); }, 0);
+    }
+}
+
 onmessage = function(event) {
     var data   = JSON.parse(event.data),
         action = data.action,
         args   = data.args,
-        ret    = { action: action };
-    
-    if (action === 'new') {
-        connect4 = new Connect4Game(args[0]);
-        ret.returnValue = connect4;
+        game   = data.game !== undefined ? games[data.game] : connect4,
+        ret    = { action: action, game: data.game, task: data.task };
+
+    try {
+        if (sliced[action]) {
+            startRun(game, action, args, ret);
+            return;
+        }
+        else if (action === 'stop') {
+            // the run is found by the task it was started for, it may be waiting on another one
+            var run = null;
+            for (var i=0; i<runs.length; i++) {
+                runs[i].ret.task === data.task && (run = runs[i]);
+            }
+            if (run) {
+                endRun(run);
+                ret.returnValue = run.game[run.action.stop]();
+            }
+            else {
+                ret.returnValue = { stopped: false, nodes: 0 };
+            }
+        }
+        else if (action === 'new') {
+            game = new Connect4Game(args[0]);
+            if (data.game !== undefined) {
+                games[data.game] = game;
+            }
+            else {
+                connect4 = game;
+            }
+            ret.returnValue = game;
+        }
+        else if (action === 'drop') {
+            // the game has moved on, to another page or for good, and its replica goes with it
+            delete games[data.game];
+            game = null;
+            ret.returnValue = true;
+        }
+        else if (game[action]) {
+            ret.returnValue = game[action].apply(game, args);
+        }
+        else {
+            throw new Error('No method for requested action: ' + action);
+        }
     }
-    else if (connect4[action]) {
-        ret.returnValue = connect4[action].apply(connect4, args);
+    catch (e) {
+        // an action that fails still gets a reply, or whoever sent it would wait for one forever
+        fail(ret, e);
     }
-    else {
-        ret.returnValue = { error: 'No method for requested action: ' + action };
-    }
-    
-    postMessage(JSON.stringify(ret));
-};
\ No newline at end of file
+
+    reply(game, ret);
+};
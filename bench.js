@@ -0,0 +1,713 @@
+/**
+ * @fileOverview A load generator for the Connect4.js game, used by bench.html. It drives the public API the way a
+ * page full of players would, either with a synthetic mix of sessions or by replaying a recorded trace of
+ * requests, and reports the throughput, the latency percentiles and the missed deadlines at each offered load.
+ * Unlike a search benchmark this measures everything between a request and its answer: the queueing in the shared
+ * pool, the workers, the overload policy and the messages in between.
+ */
+var Connect4Bench = {
+    /**
+     * The kinds of sessions of the synthetic mixes. Each plays a game against autoMove at the given difficulty
+     * (see Connect4Game.difficulties) with think milliseconds between the answer to a move and the next one, for
+     * at most moves moves. A human plays random columns with makeMove, selfplay has autoMove play both sides and
+     * analysis plays random columns up to solveAt pieces and then solves the position.
+     */
+    profiles: {
+        human: { ai: 'casual', think: 3000, moves: 42 },
+        club: { ai: 'club', think: 1500, moves: 42 },
+        selfplay: { ai: 4, think: 0, moves: 42, selfplay: true },
+        analysis: { ai: 4, think: 0, moves: 42, solveAt: 26 }
+    },
+
+    /**
+     * The synthetic mixes, the weight of each kind of session.
+     */
+    mixes: {
+        casual: { human: 8, club: 2 },
+        busy: { human: 5, club: 3, selfplay: 2 },
+        mixed: { human: 5, club: 2, selfplay: 2, analysis: 1 }
+    },
+
+    /**
+     * The fixed positions of the scaling benchmark, as the columns played from an empty 7x6 board starting with
+     * player 1. They are 14 to 17 moves from the end and take each between half a second and a few seconds to
+     * solve on a single worker.
+     */
+    positions: [
+        '1444403316055465632111214620',
+        '545464453302030360625635034',
+        '46063130320324120033564260',
+        '4344146553120011443011235',
+        '642165050313262665444610113',
+        '65304552532305350130622630'
+    ],
+
+    /**
+     * The positions of the solver benchmark with their exact scores (see Connect4Game#solve), as the columns
+     * played from an empty 7x6 board starting with player 1, with no immediate win for the player to move. They
+     * are bucketed by stage, end being 10 to 12 moves from the end, late 13 to 15 and middle 16 to 18, and by
+     * difficulty, Connect4Game#solve searching fewer than 300 positions for easy ones and up to 8000 for hard
+     * ones. The positions come from random games that avoid handing out immediate wins. Their scores were
+     * computed by a separate, much simpler reference solver, and Connect4Game#solve agrees with every one.
+     */
+    corpus: {
+        'end easy': [
+            ['6635543261660033522054163231120', -10],
+            ['0513124344061141326052264224100', -4],
+            ['061550323626636520316100211251', 10],
+            ['00263124526231133145145224144500', 0]
+        ],
+        'end hard': [
+            ['4345261330642450644306021061155', 7],
+            ['3050121625113353512644412255366', 0],
+            ['44306504215636121661264440553300', -1],
+            ['524216311224334411524030343126', 6]
+        ],
+        'late easy': [
+            ['00420526052223455244445335001', -10],
+            ['42512661465244411161645263002', -12],
+            ['631600240500261661221416220', 13],
+            ['16556106642324562244645450202', -12]
+        ],
+        'late hard': [
+            ['03113441065113654656322200653', -2],
+            ['1650436016051104135661654040', 8],
+            ['60002223342546531311062260613', 0],
+            ['0520314551114063200055124452', 4]
+        ],
+        'middle easy': [
+            ['10351005064244663244224522', -15],
+            ['44134061451510110552202363', -15],
+            ['51221034445241064420112102', 14],
+            ['1213003602201540066642462', -16]
+        ],
+        'middle hard': [
+            ['313640425503442154511221', -17],
+            ['233630332060031150221514', 16],
+            ['5545364225561431056620664', 0],
+            ['2421541302400320253244405', -8]
+        ]
+    },
+
+    /**
+     * The trace recorded since record was called, or null when not recording.
+     */
+    trace: null
+};
+
+/**
+ * Records the requests made to every game from now on: each is an entry with time, the milliseconds since the
+ * recording started, session, the id of the game, action, one of new, autoMove, makeMove and solve, and args. A
+ * game's first request is preceded by a new entry with its settings. Recorded games replay the same way only with
+ * the seed setting, otherwise replayed moves that are no longer possible are skipped.
+ */
+Connect4Bench.record = function() {
+    var started = new Date().getTime(), seen = {}, trace = Connect4Bench.trace = [];
+
+    function wrap(action) {
+        var original = Connect4.prototype[action];
+        Connect4.prototype[action] = function() {
+            if (Connect4Bench.trace === trace) {
+                var now = new Date().getTime() - started;
+                if (!seen[this._id]) {
+                    seen[this._id] = true;
+                    trace.push({ time: now, session: this._id, action: 'new', args: [this._gameSettings] });
+                }
+                trace.push({ time: now, session: this._id, action: action,
+                    args: action === 'solve' ? [arguments[0]] : [].slice.call(arguments) });
+            }
+            return original.apply(this, arguments);
+        };
+        Connect4.prototype[action]._original = original;
+    }
+
+    if (!Connect4.prototype.autoMove._original) {
+        wrap('autoMove');
+        wrap('makeMove');
+        wrap('solve');
+    }
+};
+
+/**
+ * Stops recording.
+ *
+ * @returns {array} The trace.
+ */
+Connect4Bench.stopRecording = function() {
+    var trace = Connect4Bench.trace;
+    Connect4Bench.trace = null;
+    return trace;
+};
+
+/**
+ * Runs the steps of a sweep one after the other, each at one of the given loads, see run.
+ *
+ * @param {object} options The options of run, without load.
+ * @param {array} loads The loads.
+ * @param {function} callback The callback to be called with the result of every step.
+ * @param {function} [progress] The callback to be called with the result of each step as it ends.
+ */
+Connect4Bench.sweep = function(options, loads, callback, progress) {
+    var results = [];
+
+    (function next() {
+        if (results.length === loads.length) {
+            callback(results);
+            return;
+        }
+
+        var step = {};
+        for (var key in options) {
+            if (options.hasOwnProperty(key)) {
+                step[key] = options[key];
+            }
+        }
+        step.load = loads[results.length];
+
+        Connect4Bench.run(step, function(result) {
+            results.push(result);
+            progress && progress(result);
+            next();
+        });
+    })();
+};
+
+/**
+ * Runs one step of load for a while and reports on the requests made during it. In the closed loop mode load is
+ * the number of sessions kept going at once, a session being replaced as soon as it ends. In the open loop mode
+ * load is the number of new sessions per second, arriving at random (Poisson) whatever the state of the ones
+ * already there. In the replay mode load is the speed of the replay, 1 being the speed of the recording, and each
+ * request is sent at its time in the trace. Requests that find their game still busy with the one before wait
+ * for it, and their latency counts from the time they should have been sent, so that a slow answer is not hidden
+ * by the requests it delayed.
+ *
+ * @param {object} options The options:
+ *                         mode: 'closed', 'open' or 'replay',
+ *                         load: the offered load, as above,
+ *                         duration: how many milliseconds the step sends requests for, defaults to 30000,
+ *                         mix: the name of a mix or a mix of its own, see Connect4Bench.mixes, defaults to casual,
+ *                         trace: the trace to replay, see record,
+ *                         settings: settings given to every game on top of the ones of its session,
+ *                         drain: how many milliseconds to wait for the requests in flight once the step is over,
+ *                                defaults to 10000.
+ * @param {function} callback The callback to be called with the result, an object with the following properties:
+ *                            mode, load, duration: as given,
+ *                            sessions: the sessions started,
+ *                            offered: the requests sent per second,
+ *                            throughput: the requests answered per second, within the step,
+ *                            latency: the latency of every answered request in milliseconds, as the p50, p99
+ *                                     and p999 percentiles and the max,
+ *                            actions: the same for each action with its count,
+ *                            missed: the autoMoves answered after their moveDeadline,
+ *                            unanswered: the requests still in flight when the drain ran out,
+ *                            skipped: the replayed moves that were no longer possible.
+ */
+Connect4Bench.run = function(options, callback) {
+    var mode     = options.mode || 'closed',
+        duration = options.duration || 30000,
+        drain    = options.drain !== undefined ? options.drain : 10000,
+        mix      = typeof options.mix === 'object' ? options.mix : Connect4Bench.mixes[options.mix || 'casual'],
+        started  = new Date().getTime(),
+        stopped  = false,
+        games    = [],
+        timers   = [],
+        samples  = [],
+        counts   = { sessions: 0, sent: 0, answered: 0, unanswered: 0, skipped: 0, missed: 0 };
+
+    function later(fn, delay) {
+        timers.push(setTimeout(fn, Math.max(0, delay)));
+    }
+
+    // sends a request once the game is free, and times it from when it was due
+    function send(session, due, action, args, after) {
+        var game = session.game;
+
+        if (game.moveInProgress || game.solveInProgress || session.busy) {
+            session.waiting.push([due, action, args, after]);
+            return;
+        }
+        if (game.gameOver || (action === 'makeMove' && game.board[args[1]][game.rows - 1] !== -1)) {
+            counts.skipped++;
+            after && after(false);
+            return;
+        }
+
+        counts.sent++;
+        counts.unanswered++;
+        session.busy = true;
+
+        function answered() {
+            var latency = new Date().getTime() - due;
+            counts.unanswered--;
+            counts.answered += stopped ? 0 : 1;
+            session.busy = false;
+            samples.push([action, latency]);
+            if (action === 'autoMove' && latency > game._settings.moveDeadline) {
+                counts.missed++;
+            }
+            var waiting = session.waiting.shift();
+            waiting && send(session, waiting[0], waiting[1], waiting[2], waiting[3]);
+            after && after(true);
+        }
+
+        if (action === 'solve') {
+            game.solve(args[0], answered);
+        }
+        else {
+            session.answered = answered;
+            game[action].apply(game, args);
+        }
+    }
+
+    // starts a game, and the request that creates it counts like any other
+    function start(settings, ready) {
+        var due = new Date().getTime(), session = { game: null, busy: true, waiting: [], answered: null };
+
+        counts.sessions++;
+        counts.sent++;
+        counts.unanswered++;
+        new Connect4(settings, function(game) {
+            counts.unanswered--;
+            counts.answered += stopped ? 0 : 1;
+            samples.push(['new', new Date().getTime() - due]);
+            session.game = game;
+            session.busy = false;
+            game.subscribe('moveend', function() {
+                var answered = session.answered;
+                session.answered = null;
+                answered && answered();
+            });
+            games.push(game);
+            ready(session);
+        });
+    }
+
+    function settingsFor(profile) {
+        var settings = { ai: profile.ai };
+        for (var key in options.settings) {
+            if (options.settings.hasOwnProperty(key)) {
+                settings[key] = options.settings[key];
+            }
+        }
+        return settings;
+    }
+
+    function pickProfile() {
+        var total = 0, pick;
+        for (var name in mix) {
+            if (mix.hasOwnProperty(name)) {
+                total += mix[name];
+            }
+        }
+        pick = Math.random() * total;
+        for (var name in mix) {
+            if (mix.hasOwnProperty(name) && (pick -= mix[name]) < 0) {
+                return Connect4Bench.profiles[name];
+            }
+        }
+        return Connect4Bench.profiles[name];
+    }
+
+    // plays a synthetic session until its game ends, then calls ended
+    function play(profile, ended) {
+        start(settingsFor(profile), function(session) {
+            var game = session.game, moves = 0;
+
+            (function next(player) {
+                if (stopped || game.gameOver || moves >= profile.moves) {
+                    game.close();
+                    games.splice(games.indexOf(game), 1);
+                    ended && !stopped && ended();
+                    return;
+                }
+
+                later(function() {
+                    var due = new Date().getTime(), columns = [];
+                    if (stopped) {
+                        next(player);
+                        return;
+                    }
+                    moves++;
+                    if (profile.solveAt && game.numberOfPieces >= profile.solveAt) {
+                        send(session, due, 'solve', [player], function() { moves = profile.moves; next(player); });
+                    }
+                    else if (player === 0 && !profile.selfplay) {
+                        for (var i=0; i<game.columns; i++) {
+                            game.board[i][game.rows - 1] === -1 && columns.push(i);
+                        }
+                        send(session, due, 'makeMove', [player, columns[Math.floor(Math.random() * columns.length)]],
+                            function() { next(player ^ 1); });
+                    }
+                    else {
+                        send(session, due, 'autoMove', [player], function() { next(player ^ 1); });
+                    }
+                }, player === 0 ? profile.think : 0);
+            })(0);
+        });
+    }
+
+    function replay(trace) {
+        var sessions = {}, speed = options.load || 1;
+
+        for (var i=0; i<trace.length; i++) {
+            (function(entry) {
+                var due = started + Math.round(entry.time / speed);
+                if (due - started >= duration) { return; }
+                later(function() {
+                    if (entry.action === 'new') {
+                        sessions[entry.session] = { pending: [] };
+                        start(entry.args[0], function(session) {
+                            var pending = sessions[entry.session].pending;
+                            sessions[entry.session] = session;
+                            for (var j=0; j<pending.length; j++) {
+                                send(session, pending[j][0], pending[j][1], pending[j][2]);
+                            }
+                        });
+                    }
+                    else if (sessions[entry.session] && !sessions[entry.session].game) {
+                        sessions[entry.session].pending.push([due, entry.action, entry.args]);
+                    }
+                    else if (sessions[entry.session]) {
+                        send(sessions[entry.session], due, entry.action, entry.args);
+                    }
+                }, due - new Date().getTime());
+            })(trace[i]);
+        }
+    }
+
+    function finish() {
+        for (var i=0; i<timers.length; i++) {
+            clearTimeout(timers[i]);
+        }
+
+        var result = {
+            mode: mode,
+            load: options.load,
+            duration: duration,
+            sessions: counts.sessions,
+            offered: counts.sent / (duration / 1000),
+            throughput: counts.answered / (duration / 1000),
+            latency: Connect4Bench.percentiles(samples),
+            actions: {},
+            missed: counts.missed,
+            unanswered: counts.unanswered,
+            skipped: counts.skipped
+        };
+        for (var i=0; i<samples.length; i++) {
+            var action = result.actions[samples[i][0]] = result.actions[samples[i][0]] || [];
+            action.push(samples[i]);
+        }
+        for (var action in result.actions) {
+            if (result.actions.hasOwnProperty(action)) {
+                var latency = Connect4Bench.percentiles(result.actions[action]);
+                latency.count = result.actions[action].length;
+                result.actions[action] = latency;
+            }
+        }
+
+        for (var i=0; i<games.length; i++) {
+            if (!games[i].moveInProgress && !games[i].solveInProgress) {
+                games[i].close();
+            }
+        }
+        callback(result);
+    }
+
+    if (mode === 'replay') {
+        replay(options.trace);
+    }
+    else if (mode === 'open') {
+        (function arrive() {
+            // exponential gaps between arrivals make a Poisson process
+            later(function() {
+                if (!stopped) {
+                    play(pickProfile());
+                    arrive();
+                }
+            }, -Math.log(1 - Math.random()) * 1000 / options.load);
+        })();
+    }
+    else {
+        for (var i=0; i<options.load; i++) {
+            (function keep() {
+                play(pickProfile(), keep);
+            })();
+        }
+    }
+
+    setTimeout(function() {
+        stopped = true;
+        var waited = 0;
+        (function wait() {
+            if (counts.unanswered === 0 || waited >= drain) {
+                finish();
+                return;
+            }
+            waited += 100;
+            setTimeout(wait, 100);
+        })();
+    }, duration);
+};
+
+/**
+ * Gets the p50, p99 and p999 percentiles and the max of [action, latency] samples, by nearest rank.
+ *
+ * @param {array} samples The samples.
+ *
+ * @returns {object} The percentiles, null when there are no samples.
+ */
+Connect4Bench.percentiles = function(samples) {
+    var sorted = [];
+    for (var i=0; i<samples.length; i++) {
+        sorted.push(samples[i][1]);
+    }
+    sorted.sort(function(a, b) { return a - b; });
+
+    function rank(p) {
+        return sorted.length ? sorted[Math.max(0, Math.ceil(p * sorted.length) - 1)] : null;
+    }
+
+    return { p50: rank(0.5), p99: rank(0.99), p999: rank(0.999), max: rank(1) };
+};
+
+/**
+ * Measures how the parallel modes scale with the number of workers. For each worker count the shared pool is
+ * replaced by one of that size (see Connect4.closePool) and the same work is done again:
+ * solve: every position is solved in turn with the workers setting at the worker count and tables of its own,
+ *        which measures the split solve (see Connect4#solve),
+ * batch: a game is set up in the first ten moves of each position, where searches are the longest, batch times
+ *        over with a seed of its own so that none of the searches are coalesced, and all of them autoMove at
+ *        once, which measures how many independent searches the pool gets through.
+ * The speedup is the time at one worker over the time at the worker count (or, when the counts do not start at
+ * one, the first count taken as scaling perfectly), the efficiency the speedup per worker
+ * and the extra nodes the share of nodes searched on top of the ones searched at one worker, which for a solve is
+ * the price of handing jobs out before the bounds of the ones before them are known.
+ *
+ * Pages cannot pin workers to cores, or tell how many of the logical cores are physical ones, so worker counts
+ * past the physical cores measure hyperthreads and the operating system decides where each worker runs.
+ *
+ * @param {object} options The options:
+ *                         modes: the modes to run, defaults to ['solve', 'batch'],
+ *                         workers: the worker counts, defaults to the powers of two up to the logical cores and
+ *                                  the logical cores themselves,
+ *                         positions: the positions, defaults to Connect4Bench.positions,
+ *                         level: the level of the batch autoMoves, defaults to 7,
+ *                         batch: how many games per position the batch mode sets up, defaults to 2.
+ * @param {function} callback The callback to be called with a result for each mode and worker count, an object
+ *                            with mode, workers, ms, nodes, speedup, efficiency and extraNodes.
+ * @param {function} [progress] The callback to be called with each result as it comes.
+ */
+Connect4Bench.scaling = function(options, callback, progress) {
+    var cores     = Connect4.hardware().logicalCores,
+        modes     = options.modes || ['solve', 'batch'],
+        positions = options.positions || Connect4Bench.positions,
+        counts    = options.workers,
+        results   = [],
+        baseline  = {},
+        steps     = [];
+
+    if (!counts) {
+        counts = [];
+        for (var count=1; count<cores; count*=2) {
+            counts.push(count);
+        }
+        counts.push(cores);
+    }
+    for (var i=0; i<modes.length; i++) {
+        for (var j=0; j<counts.length; j++) {
+            steps.push([modes[i], counts[j]]);
+        }
+    }
+
+    (function next() {
+        if (results.length === steps.length) {
+            Connect4.closePool();
+            callback(results);
+            return;
+        }
+
+        var mode = steps[results.length][0], workers = steps[results.length][1];
+        Connect4.closePool();
+        Connect4.pool(workers);
+        Connect4Bench['_' + mode](options, positions, workers, function(ms, nodes) {
+            var result = { mode: mode, workers: workers, ms: ms, nodes: nodes };
+
+            baseline[mode] = baseline[mode] || result;
+            result.speedup = baseline[mode].ms / ms * baseline[mode].workers;
+            result.efficiency = result.speedup / workers;
+            result.extraNodes = nodes / baseline[mode].nodes - 1;
+            results.push(result);
+            progress && progress(result);
+            next();
+        });
+    })();
+};
+
+/**
+ * Solves every position in turn on the given number of workers, calling back with the time and nodes it took.
+ * As in Connect4Bench.solver, each solve has tables of its own and its nodes are the ones it reports.
+ * @private
+ */
+Connect4Bench._solve = function(options, positions, workers, callback) {
+    var ms = 0, nodes = 0;
+
+    (function next(index) {
+        if (index === positions.length) {
+            callback(ms, nodes);
+            return;
+        }
+
+        var settings = { workers: workers, autoConfigure: false, idleTimeout: 0, shareTables: false };
+        Connect4Bench._setUp(settings, positions[index], function(game) {
+            var started = new Date().getTime();
+            game.solve(positions[index].length % 2, function(result) {
+                ms += new Date().getTime() - started;
+                nodes += result.nodes;
+                game.close();
+                next(index + 1);
+            });
+        });
+    })(0);
+};
+
+/**
+ * Has a batch of games in the positions autoMove at once, calling back with the time and nodes it took.
+ * @private
+ */
+Connect4Bench._batch = function(options, positions, workers, callback) {
+    var size = positions.length * (options.batch || 2), games = [], started, before, answered = 0;
+
+    function nodes() {
+        return +Connect4.metrics().match(/^connect4_nodes_total (\S+)$/m)[1];
+    }
+
+    for (var i=0; i<size; i++) {
+        var settings = { ai: options.level || 7, seed: i + 1, degrade: false, autoConfigure: false, idleTimeout: 0 };
+        Connect4Bench._setUp(settings, positions[i % positions.length].slice(0, 10), function(game) {
+            games.push(game);
+            if (games.length === size) {
+                // once the moveend of the last move played is over, or it would count as an answer
+                setTimeout(start, 0);
+            }
+        });
+    }
+
+    function start() {
+        started = new Date().getTime();
+        before = nodes();
+        for (var j=0; j<size; j++) {
+            (function(game) {
+                game.subscribe('moveend', function() {
+                    if (++answered === size) {
+                        var ms = new Date().getTime() - started, searched = nodes() - before;
+                        for (var k=0; k<size; k++) {
+                            games[k].close();
+                        }
+                        callback(ms, searched);
+                    }
+                });
+                game.autoMove(game.numberOfPieces % 2);
+            })(games[j]);
+        }
+    }
+};
+
+/**
+ * Creates a game and plays the columns of a position with makeMove, calling back once it is there.
+ * @private
+ */
+Connect4Bench._setUp = function(settings, position, callback) {
+    new Connect4(settings, function(game) {
+        var played = 0;
+        game.subscribe('moveend', function() {
+            if (++played < position.length) {
+                game.makeMove(played % 2, +position.charAt(played));
+            }
+            else if (played === position.length) {
+                callback(game);
+            }
+        });
+        position.length ? game.makeMove(0, +position.charAt(0)) : callback(game);
+    });
+};
+
+/**
+ * Runs the exact solver over the corpus (see Connect4Bench.corpus) and checks every score against the known one.
+ * Each position is solved through Connect4#solve, in a fresh game with tables of its own (the shareTables
+ * setting is off) so that no position benefits from the transposition table entries of the one before. The nodes
+ * are the ones the solve reports, which include those of the job that checks the best column.
+ *
+ * @param {object} options The options:
+ *                         corpus: the corpus, defaults to Connect4Bench.corpus,
+ *                         buckets: the names of the buckets to run, defaults to all of them,
+ *                         workers: the workers setting of the solves, defaults to 1 so that the times measure the
+ *                                  solver rather than the split.
+ * @param {function} callback The callback to be called with the report, an object with the following properties:
+ *                            passed: whether every score was the known one,
+ *                            failures: the positions whose score was not, with their bucket, position, expected
+ *                                      and score,
+ *                            buckets: for each bucket its positions, failures, meanMs, maxMs, meanNodes,
+ *                                     maxNodes and nodesPerSecond.
+ * @param {function} [progress] The callback to be called after each position with its bucket, position,
+ *                              expected, score, ms, nodes and ok.
+ */
+Connect4Bench.solver = function(options, callback, progress) {
+    var corpus  = options.corpus || Connect4Bench.corpus,
+        names   = options.buckets,
+        jobs    = [],
+        report  = { passed: true, failures: [], buckets: {} };
+
+    if (!names) {
+        names = [];
+        for (var name in corpus) {
+            corpus.hasOwnProperty(name) && names.push(name);
+        }
+    }
+    for (var i=0; i<names.length; i++) {
+        report.buckets[names[i]] = { positions: 0, failures: 0, meanMs: 0, maxMs: 0, meanNodes: 0, maxNodes: 0,
+                                     nodesPerSecond: 0 };
+        for (var j=0; j<corpus[names[i]].length; j++) {
+            jobs.push([names[i], corpus[names[i]][j][0], corpus[names[i]][j][1]]);
+        }
+    }
+
+    (function next(index) {
+        if (index === jobs.length) {
+            for (var name in report.buckets) {
+                if (!report.buckets.hasOwnProperty(name)) { continue; }
+                var bucket = report.buckets[name];
+                bucket.nodesPerSecond = bucket.meanMs ? bucket.meanNodes / bucket.meanMs * 1000 : 0;
+                bucket.meanMs /= bucket.positions || 1;
+                bucket.meanNodes /= bucket.positions || 1;
+            }
+            callback(report);
+            return;
+        }
+
+        var job      = jobs[index],
+            settings = { workers: options.workers || 1, autoConfigure: false, idleTimeout: 0, shareTables: false };
+        Connect4Bench._setUp(settings, job[1], function(game) {
+            var started = new Date().getTime();
+            game.solve(job[1].length % 2, function(result) {
+                var ms = new Date().getTime() - started, bucket = report.buckets[job[0]], nodes = result.nodes,
+                    outcome = { bucket: job[0], position: job[1], expected: job[2], score: result.score, ms: ms,
+                                nodes: nodes, ok: result.score === job[2] };
+
+                game.close();
+                // totals for now, turned into means at the end
+                bucket.positions++;
+                bucket.meanMs += ms;
+                bucket.maxMs = Math.max(bucket.maxMs, ms);
+                bucket.meanNodes += nodes;
+                bucket.maxNodes = Math.max(bucket.maxNodes, nodes);
+                if (!outcome.ok) {
+                    bucket.failures++;
+                    report.passed = false;
+                    report.failures.push({ bucket: job[0], position: job[1], expected: job[2], score: result.score });
+                }
+                progress && progress(outcome);
+                next(index + 1);
+            });
+        });
+    })(0);
+};
@@ -0,0 +1,539 @@
+/**
+ * @fileOverview Checks of the engine and of the page API that run in node, without a browser: node check.js. The
+ * page and its workers each get a context of their own, and messages between them go through setImmediate as
+ * they would through a message loop. Each check either passes or says what it found, and the process exits with
+ * the number of checks that failed.
+ */
+var vm   = require('vm'),
+    fs   = require('fs'),
+    path = require('path');
+
+/**
+ * Runs one of the files of the game in a context.
+ */
+function load(context, file) {
+    vm.runInContext(fs.readFileSync(path.join(__dirname, file), 'utf8'), context, { filename: file });
+}
+
+/**
+ * Creates a context with what the files of the game expect of the browser.
+ */
+function context(extra) {
+    var ctx = { console: console, setTimeout: setTimeout, clearTimeout: clearTimeout, Date: Date, Math: Math,
+                JSON: JSON, navigator: { hardwareConcurrency: 4 } };
+    for (var key in extra) {
+        ctx[key] = extra[key];
+    }
+    ctx.self = ctx.window = ctx;
+    return vm.createContext(ctx);
+}
+
+/**
+ * A Web Worker running Connect4Worker.js in a context of its own.
+ */
+function Worker(file) {
+    var self = this;
+    this._closed = false;
+    this._context = context({
+        importScripts: function() {
+            for (var i=0; i<arguments.length; i++) {
+                load(self._context, arguments[i]);
+            }
+        },
+        postMessage: function(data) {
+            setImmediate(function() {
+                !self._closed && self.onmessage && self.onmessage({ data: data });
+            });
+        }
+    });
+    load(this._context, file);
+}
+
+Worker.prototype.postMessage = function(data) {
+    var self = this;
+    setImmediate(function() {
+        !self._closed && self._context.onmessage({ data: data });
+    });
+};
+
+Worker.prototype.terminate = function() {
+    this._closed = true;
+};
+
+/**
+ * Creates a page with Connect4.js and bench.js loaded.
+ */
+function page() {
+    var ctx = context({ Worker: Worker });
+    load(ctx, 'Connect4.js');
+    load(ctx, 'bench.js');
+    return ctx;
+}
+
+/**
+ * Creates a context with the engine loaded, as a worker has it.
+ */
+function engine() {
+    var ctx = context({ postMessage: function() {} });
+    load(ctx, 'Connect4Game.js');
+    load(ctx, 'Connect4Table.js');
+    load(ctx, 'Connect4Tablebase.js');
+    return ctx;
+}
+
+/**
+ * Plays a position written as the columns played, starting with player 1, into an engine game.
+ */
+function play(game, position) {
+    var moves = [];
+    for (var i=0; i<position.length; i++) {
+        moves.push([i % 2, +position.charAt(i)]);
+    }
+    game.loadMoves(moves);
+    return moves;
+}
+
+/**
+ * The checks, by name. Each calls done with nothing when it passes and with what went wrong otherwise.
+ */
+var checks = {
+    'perft counts the known lines and positions on 7x6': function(done) {
+        var game   = new (engine().Connect4Game)({ tableSize: 0 }),
+            nodes  = [1, 7, 49, 343, 2401, 16807],
+            unique = [1, 7, 49, 238, 1120, 4263];
+
+        for (var depth=0; depth<nodes.length; depth++) {
+            var counts = game.perft(0, depth, [], true);
+            if (counts.nodes !== nodes[depth] || counts.keys.length !== unique[depth]) {
+                return done('depth ' + depth + ': ' + counts.nodes + ' lines and ' + counts.keys.length +
+                    ' positions');
+            }
+        }
+        done();
+    },
+
+    'perft split across the pool counts what the engine does': function(done) {
+        var P = page();
+        P.Connect4.pool(3);
+        new P.Connect4({ cols: 4, rows: 4, connect: 3, idleTimeout: 0 }, function(game) {
+            var counts = new (engine().Connect4Game)({ cols: 4, rows: 4, connect: 3, tableSize: 0 })
+                .perft(0, 8, [], true);
+            game.perft(0, 8, function(result) {
+                P.Connect4.closePool();
+                done(result.nodes === counts.nodes && result.terminal === counts.terminal &&
+                     result.unique === counts.keys.length ? null :
+                     'split ' + JSON.stringify(result) + ', engine ' + counts.nodes + ' ' + counts.terminal + ' ' +
+                     counts.keys.length);
+            }, null, true);
+        });
+    },
+
+    'perft in slices counts what it counts at once': function(done) {
+        var game  = new (engine().Connect4Game)({ tableSize: 0 }),
+            moves = play(new (engine().Connect4Game)({ tableSize: 0 }), '3322'),
+            whole = game.perft(0, 4, moves, true),
+            slices = 0,
+            counts;
+
+        game.startPerft(0, 4, moves, true);
+        while (!(counts = game.continuePerft(97)).done) {
+            slices++;
+        }
+        delete counts.done;
+        done(JSON.stringify(counts) === JSON.stringify(whole) && slices && game._stateStack.length === 1 ? null :
+            'in ' + slices + ' slices ' + counts.nodes + ' ' + counts.terminal + ' ' + counts.visited + ', at once ' +
+            whole.nodes + ' ' + whole.terminal + ' ' + whole.visited);
+    },
+
+    'perft of a game that is over counts the game alone': function(done) {
+        var P = page();
+        P.Connect4.pool(2);
+        P.Connect4Bench._setUp({ cols: 4, rows: 4, connect: 3, autoConfigure: false, idleTimeout: 0 }, '00112',
+            function(game) {
+                game.perft(1, 3, function(result) {
+                    P.Connect4.closePool();
+                    done(game.gameOver && result.nodes === 0 && result.terminal === 1 && result.visited === 1 ? null :
+                        'over ' + game.gameOver + ', counted ' + JSON.stringify(result));
+                });
+            });
+    },
+
+    'a game with a perft in the pool is compacted or closed only once it is done': function(done) {
+        var P = page(), E = engine(),
+            expected = new E.Connect4Game({ cols: 4, rows: 4, connect: 3, tableSize: 0 }).perft(0, 6, []).nodes;
+        P.Connect4.pool(1);
+        P.Connect4Bench._setUp({ cols: 4, rows: 4, connect: 3, autoConfigure: false, idleTimeout: 0 }, '',
+            function(game) {
+                var worker = P.Connect4.pool()._workers[0];
+                game.perft(0, 6, function(result) {
+                    var kept = !!worker.games[game._id] || !!worker.metrics[game._id];
+                    P.Connect4.closePool();
+                    done(result.nodes !== expected || game.compacted || !open || kept ? 'counted ' + result.nodes +
+                        ' of ' + expected + ', compacted ' + game.compacted + ', replica kept while running ' +
+                        open + ' and after ' + kept : null);
+                });
+                game._compact();
+                game.close();
+                var open = !!worker.games[game._id];
+            });
+    },
+
+    'a tablebase probe finds every stored value through a small cache': function(done) {
+        var E = engine(), game = new E.Connect4Game({ cols: 4, rows: 4, connect: 3 }),
+            boards = [], entries = [], seen = {};
+
+        // every position of the first six moves, with its value for the player to move
+        (function walk(player, depth) {
+            var index = E.Connect4Tablebase.index(game.currentState.board, 4, 4);
+            if (!seen[index] && !game.currentState.gameOver) {
+                seen[index] = true;
+                var value = E.Connect4Tablebase.value(game.solve(player).score);
+                boards.push([game._clone(game.currentState.board), value]);
+                entries.push([index, value]);
+            }
+            for (var i=0; depth && !game.currentState.gameOver && i<4; i++) {
+                game._pushState();
+                game._dropPiece(player, i) >= 0 && walk(player ^ 1, depth - 1);
+                game._popState();
+            }
+        })(0, 6);
+
+        // the table as it would be saved and loaded
+        var table  = JSON.parse(JSON.stringify(E.Connect4Tablebase.build({ cols: 4, rows: 4, connect: 3 }, entries,
+                64))),
+            reader = new E.Connect4Tablebase(table, 3),
+            probes = 0;
+        if (reader._bytes.length * 8 > table.blocks.length * table.blockSize * 2) {
+            return done('the table takes ' + reader._bytes.length + ' bytes for ' + table.blocks.length + ' blocks');
+        }
+        for (var round=0; round<3; round++) {
+            for (var i=0; i<boards.length; i++) {
+                var board = boards[(i * 7919 + round) % boards.length], value = reader.probe(board[0]);
+                probes++;
+                if (value !== board[1]) {
+                    return done('probe ' + probes + ' found ' + value + ' rather than ' + board[1]);
+                }
+            }
+        }
+        done(reader.hits + reader.misses !== probes || reader._cached > 3 ? 'the cache counted ' + reader.hits +
+            ' hits and ' + reader.misses + ' misses for ' + probes + ' probes and holds ' + reader._cached +
+            ' blocks' : null);
+    },
+
+    'a move searched in slices is the move searched at once': function(done) {
+        var lines = [['32', 6], ['33', 'club'], ['3322', { level: 7, margin: 2 }], ['334411', 6]];
+
+        for (var i=0; i<lines.length; i++) {
+            // games of one context share their tables, so each search gets a context of its own
+            var settings = { seed: 7, trace: true },
+                whole    = new (engine().Connect4Game)(settings),
+                sliced   = new (engine().Connect4Game)(settings),
+                moves    = play(new (engine().Connect4Game)({ tableSize: 0 }), lines[i][0]),
+                player   = moves.length % 2,
+                expected = whole.searchMove(moves, player, lines[i][1]),
+                slices   = 0,
+                result;
+
+            sliced.startSearch(moves, player, lines[i][1]);
+            while (!(result = sliced.continueSearch(37)).done) {
+                slices++;
+            }
+            delete result.done;
+            delete expected.done;
+            if (JSON.stringify(result) !== JSON.stringify(expected) || !slices) {
+                return done(lines[i][0] + ' in ' + slices + ' slices: ' + result.column + ' at ' + result.level +
+                    ' in ' + result.nodes + ' nodes rather than ' + expected.column + ' at ' + expected.level +
+                    ' in ' + expected.nodes);
+            }
+        }
+        done();
+    },
+
+    'a move under a quota is found at every level': function(done) {
+        var game  = new (engine().Connect4Game)({ quota: { nodes: 3000 }, tableSize: 0 }),
+            moves = play(new (engine().Connect4Game)({ tableSize: 0 }), '3322');
+
+        for (var level=0; level<=20; level++) {
+            var found = game.searchMove(moves, 0, level);
+            if (found.column < 0 || found.level < 2 || found.level > Math.max(level, 2)) {
+                return done('level ' + level + ' found ' + found.column + ' at ' + found.level);
+            }
+        }
+        done();
+    },
+
+    'a move on the clock is found at the lowest and highest levels': function(done) {
+        var moves = play(new (engine().Connect4Game)({ tableSize: 0 }), '3322'),
+            clock = { remaining: 3000, increment: 100 },
+            games = [new (engine().Connect4Game)(), new (engine().Connect4Game)({ quota: { nodes: 20000 } })];
+
+        for (var i=0; i<games.length; i++) {
+            var levels = [0, 1, 20];
+            for (var j=0; j<levels.length; j++) {
+                var found = games[i].searchMove(moves, 0, levels[j], 0, clock);
+                if (found.column < 0 || found.level < 2) {
+                    return done((i ? 'under a quota ' : '') + 'level ' + levels[j] + ' found ' + found.column +
+                        ' at ' + found.level);
+                }
+            }
+        }
+        done();
+    },
+
+    'a live move gets in between the slices of a deep one': function(done) {
+        var P = page(), order = [];
+        // a single worker, so the live move has nowhere to go but in between the slices of the deep one
+        P.Connect4.pool(1);
+
+        P.Connect4Bench._setUp({ autoConfigure: false, idleTimeout: 0, degrade: false }, '32', function(deep) {
+            P.Connect4Bench._setUp({ autoConfigure: false, idleTimeout: 0, degrade: false }, '32', function(live) {
+                deep.subscribe('moveend', function() {
+                    var interleaved = P.Connect4.pool().interleaved;
+                    order.push('deep');
+                    P.Connect4.closePool();
+                    done(order.join() === 'live,deep' && interleaved === 1 ? null : 'the moves ended ' +
+                        order.join(' then ') + ' with ' + interleaved + ' interleaved');
+                });
+                deep.autoMove(0, 9);
+
+                setTimeout(function() {
+                    live.subscribe('moveend', function() {
+                        order.push('live');
+                    });
+                    live.autoMove(0, 4);
+                }, 20);
+            });
+        });
+    },
+
+    'a live move goes to an idle worker rather than in between slices': function(done) {
+        var P = page(), order = [];
+        P.Connect4.pool(3);
+
+        P.Connect4Bench._setUp({ autoConfigure: false, idleTimeout: 0, degrade: false }, '32', function(deep) {
+            P.Connect4Bench._setUp({ autoConfigure: false, idleTimeout: 0, degrade: false }, '32', function(live) {
+                deep.subscribe('moveend', function() {
+                    var interleaved = P.Connect4.pool().interleaved;
+                    order.push('deep');
+                    P.Connect4.closePool();
+                    done(order.join() === 'live,deep' && interleaved === 0 ? null : 'the moves ended ' +
+                        order.join(' then ') + ' with ' + interleaved + ' interleaved');
+                });
+                deep.autoMove(0, 9);
+
+                setTimeout(function() {
+                    live.subscribe('moveend', function() {
+                        order.push('live');
+                    });
+                    live.autoMove(0, 4);
+                }, 20);
+            });
+        });
+    },
+
+    'a move that throws in a worker fails and leaves the worker free': function(done) {
+        var P = page(), errors = [];
+        P.Connect4.pool(1);
+
+        new P.Connect4({ autoConfigure: false, idleTimeout: 0 }, function(game) {
+            // the worker of the game only keeps the position, the pool workers search
+            if (game._worker._context.connect4._deepTable) {
+                return done('the worker of the game has transposition tables');
+            }
+
+            game.subscribe('error', function(error) {
+                errors.push(error.action + ': ' + error.message);
+                if (game.moveInProgress) {
+                    return done('the move is still in progress');
+                }
+                game.autoMove(0, 4);
+            });
+            game.subscribe('moveend', function(player, column) {
+                var failed = P.Connect4.pool().failed;
+                P.Connect4.closePool();
+                done(errors.length === 1 && failed === 1 && column >= 0 ? null : 'errors ' + errors.join(', ') +
+                    ', ' + failed + ' failed, then column ' + column);
+            });
+            game.autoMove(0, 'no such difficulty');
+        });
+    },
+
+    'a snapshot with moves that cannot be played is rejected': function(done) {
+        var P = page(), snapshot = { version: P.Connect4.snapshotVersion, settings: { autoConfigure: false } };
+
+        try {
+            P.Connect4.restore({ version: snapshot.version, settings: snapshot.settings, moves: 'AB*' });
+            return done('moves that are not written as a snapshot writes them were taken');
+        }
+        catch (e) {}
+
+        // the seventh piece in the first column does not fit on the board
+        snapshot.moves = 'ABABABA';
+        var game = P.Connect4.restore(snapshot, function() {
+            done('the game started');
+        });
+        game.subscribe('error', function(error) {
+            P.Connect4.closePool();
+            done(error.action === 'restore' && P.Connect4._games.indexOf(game) < 0 ? null :
+                'the ' + error.action + ' failed and the game is still open');
+        });
+    },
+
+    'the solver bench counts the same nodes however often it runs': function(done) {
+        var P = page(), counts = [];
+        P.Connect4.pool(1);
+
+        (function run() {
+            P.Connect4Bench.solver({ buckets: ['end easy'] }, function(report) {
+                var bucket = report.buckets['end easy'];
+                counts.push(bucket.meanNodes);
+                if (!report.passed || !bucket.maxNodes) {
+                    P.Connect4.closePool();
+                    return done(JSON.stringify(report));
+                }
+                if (counts.length < 2) {
+                    return run();
+                }
+                P.Connect4.closePool();
+                // with tables shared between the games the second run would find the positions of the first
+                done(counts[0] === counts[1] ? null : 'the mean nodes went from ' + counts[0] + ' to ' + counts[1]);
+            });
+        })();
+    },
+
+    'an archive indexed in slices finds the positions the engine keys': function(done) {
+        var P      = page(),
+            lines  = ['3322', '2344', '4433', '332211', '3456', '9'],
+            games  = [],
+            keys   = {},
+            whole  = new (engine().Connect4Game)({ tableSize: 0 }),
+            sliced = new (engine().Connect4Game)({ tableSize: 0 }),
+            index;
+
+        for (var i=0; i<lines.length; i++) {
+            var moves = [];
+            for (var j=0; j<lines[i].length; j++) {
+                moves.push([j % 2, +lines[i].charAt(j)]);
+            }
+            games.push([i, moves]);
+        }
+
+        // the engine indexes the same at once and in slices, and keys each position the way the page does
+        var expected = whole.indexGames(games);
+        sliced.startIndex(games);
+        while (!(index = sliced.continueIndex(3)).done) {}
+        delete index.done;
+        if (JSON.stringify(index) !== JSON.stringify(expected)) {
+            return done('indexed in slices ' + JSON.stringify(index.skipped) + ' ' + index.games + ' games');
+        }
+        for (var i=0; i<games.length - 1; i++) {
+            for (var j=0; j<=games[i][1].length; j++) {
+                var board = new (engine().Connect4Game)({ tableSize: 0 }), line = games[i][1].slice(0, j);
+                board.loadMoves(line);
+                if (P.Connect4Archive._key(line, 7).key !== board.positionKey()) {
+                    return done(lines[i].slice(0, j) + ' has the key ' + board.positionKey() + ' in the engine');
+                }
+                keys[board.positionKey()] = true;
+            }
+        }
+
+        P.Connect4.pool(2);
+        new P.Connect4({ autoConfigure: false, idleTimeout: 0, sliceNodes: 5 }, function(game) {
+            var records = [];
+            for (var i=0; i<games.length; i++) {
+                records.push({ id: i, moves: P.Connect4._encodeMoves(games[i][1]) });
+            }
+            game.indexGames(records, function(built) {
+                var archive = new P.Connect4Archive(built);
+                P.Connect4.closePool();
+                for (var key in keys) {
+                    var found = archive.lookup(key);
+                    if (!found || found.games !== expected.positions[key].stats[0]) {
+                        return done(key + ' found ' + JSON.stringify(found));
+                    }
+                }
+                done(built.games === 5 && built.skipped.join() === '5' ? null : JSON.stringify(built.skipped));
+            });
+        });
+    },
+
+    'a split solve scores as a serial one': function(done) {
+        var P         = page(),
+            corpus    = P.Connect4Bench.corpus,
+            positions = [corpus['end easy'][0], corpus['end hard'][1], corpus['late easy'][2], corpus['late hard'][0]],
+            failures  = [];
+
+        P.Connect4.pool(3);
+        (function next(index) {
+            if (index === positions.length) {
+                P.Connect4.closePool();
+                return done(failures.length ? failures.join(', ') : null);
+            }
+
+            var position = positions[index][0],
+                serial   = new (engine().Connect4Game)(),
+                player   = position.length % 2;
+
+            play(serial, position);
+            var expected = serial.solve(player).score;
+
+            // the workers setting is how many jobs of the solve run at once, the pool how many can
+            var settings = { splitDepth: 2, workers: 3, autoConfigure: false, idleTimeout: 0 };
+            P.Connect4Bench._setUp(settings, position, function(game) {
+                game.solve(player, function(result) {
+                    if (result.score !== expected || expected !== positions[index][1]) {
+                        failures.push(position + ': split ' + result.score + ', serial ' + expected + ', known ' +
+                            positions[index][1]);
+                    }
+                    game.close();
+                    next(index + 1);
+                });
+            });
+        })(0);
+    }
+};
+
+/**
+ * Runs the checks given on the command line, or all of them, one after the other.
+ */
+(function() {
+    var names = process.argv.slice(2), failed = 0;
+
+    if (!names.length) {
+        names = Object.keys(checks);
+    }
+
+    (function next(index) {
+        if (index === names.length) {
+            console.log(failed ? failed + ' of ' + names.length + ' checks failed' : 'all ' + names.length +
+                ' checks passed');
+            process.exit(failed);
+        }
+
+        var name = names[index], started = Date.now(), timer = setTimeout(function() {
+            finish('did not finish within 5 minutes');
+        }, 300000);
+
+        function finish(error) {
+            clearTimeout(timer);
+            if (error) {
+                failed++;
+                console.log('not ok - ' + name + ': ' + error);
+            }
+            else {
+                console.log('ok - ' + name + ' (' + (Date.now() - started) + ' ms)');
+            }
+            setImmediate(function() { next(index + 1); });
+        }
+
+        if (!checks[name]) {
+            return finish('no such check');
+        }
+        try {
+            checks[name](finish);
+        }
+        catch (e) {
+            finish(e.stack || e);
+        }
+    })(0);
+})();